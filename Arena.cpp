@@ -0,0 +1,92 @@
+#include "Arena.h"
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+using namespace std;
+
+static thread_local pmr::memory_resource* currentMemory = nullptr;
+
+Arena::Arena(size_t blockSize)
+ : m_blockSize(blockSize), m_current(0), m_next(nullptr), m_end(nullptr)
+{}
+
+Arena::~Arena()
+{
+    for ( int i = 0; i < m_blocks.size(); i++)
+        free(m_blocks[i].data);
+}
+
+void Arena::reset()
+{
+    m_current = 0;
+    m_next = (m_blocks.empty() ? nullptr : m_blocks[0].data);
+    m_end = (m_blocks.empty() ? nullptr : m_blocks[0].data + m_blocks[0].size);
+}
+
+void* Arena::do_allocate(size_t bytes, size_t alignment)
+{
+    for (;;)
+    {
+        if ( m_next != nullptr )
+        {
+            size_t pad = (alignment - reinterpret_cast<uintptr_t>(m_next) % alignment) % alignment;
+            if ( pad + bytes <= size_t(m_end - m_next) )
+            {
+                void* p = m_next + pad;
+                m_next += pad + bytes;
+                return p;
+            }
+        }
+          // Move on to the next block kept from earlier games, or add one
+          // big enough for this request.
+        size_t next = (m_next == nullptr ? 0 : m_current + 1);
+        if ( next == m_blocks.size() )
+        {
+            size_t size = (bytes + alignment > m_blockSize ? bytes + alignment : m_blockSize);
+            char* data = static_cast<char*>(malloc(size));
+            if ( data == nullptr )
+                throw bad_alloc();
+            m_blocks.push_back(Block { data, size });
+        }
+        m_current = next;
+        m_next = m_blocks[next].data;
+        m_end = m_blocks[next].data + m_blocks[next].size;
+    }
+}
+
+pmr::memory_resource* gameMemory()
+{
+    return currentMemory != nullptr ? currentMemory : pmr::new_delete_resource();
+}
+
+ArenaScope::ArenaScope(pmr::memory_resource& memory)
+ : m_outer(currentMemory)
+{
+    currentMemory = &memory;
+}
+
+ArenaScope::~ArenaScope()
+{
+    currentMemory = m_outer;
+}
+
+  // Each object is preceded by the resource it came from, so delete can
+  // hand it back there whatever scope is current by then.
+const size_t OBJECT_HEADER = alignof(max_align_t);
+
+void* ArenaObject::operator new(size_t size)
+{
+    pmr::memory_resource* memory = gameMemory();
+    char* p = static_cast<char*>(memory->allocate(size + OBJECT_HEADER, OBJECT_HEADER));
+    *reinterpret_cast<pmr::memory_resource**>(p) = memory;
+    return p + OBJECT_HEADER;
+}
+
+void ArenaObject::operator delete(void* p, size_t size)
+{
+    if ( p == nullptr )
+        return;
+    char* start = static_cast<char*>(p) - OBJECT_HEADER;
+    pmr::memory_resource* memory = *reinterpret_cast<pmr::memory_resource**>(start);
+    memory->deallocate(start, size + OBJECT_HEADER, OBJECT_HEADER);
+}
@@ -0,0 +1,79 @@
+#ifndef ARENA_INCLUDED
+#define ARENA_INCLUDED
+
+#include <memory_resource>
+#include <cstddef>
+#include <vector>
+
+  // A monotonic memory resource for everything one game allocates.  Memory
+  // is handed out by bumping a pointer through blocks the arena keeps;
+  // freeing is a no-op, and reset() rewinds to the first block in O(1).
+  // Once a thread's arena has grown to fit a game, the games after it are
+  // played without calling malloc or free at all.  Not thread-safe: one
+  // arena per thread.
+class Arena : public std::pmr::memory_resource
+{
+  public:
+    explicit Arena(size_t blockSize = 64 * 1024);
+    ~Arena();
+      // Forget everything allocated so far.  Objects in the arena must
+      // already have been destroyed.
+    void reset();
+    int nBlocks() const { return m_blocks.size(); }
+
+      // We prevent an Arena object from being copied or assigned
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+  private:
+    struct Block
+    {
+        char* data;
+        size_t size;
+    };
+    std::vector<Block> m_blocks;
+    size_t m_blockSize;
+    size_t m_current;                   // index of the block being filled
+    char* m_next;
+    char* m_end;
+
+    virtual void* do_allocate(size_t bytes, size_t alignment);
+    virtual void do_deallocate(void*, size_t, size_t) {}
+    virtual bool do_is_equal(const std::pmr::memory_resource& other) const noexcept
+    {
+        return this == &other;
+    }
+};
+
+  // Where engine objects (games, boards, players, and their containers) get
+  // their memory: the resource of the innermost ArenaScope on this thread
+  // (usually an Arena), or the ordinary heap outside any scope.  Containers
+  // remember the resource they were made with, so objects must not outlive
+  // the resource current when they were created.  Objects kept across
+  // games, as a Match's are, belong in a resource that recycles what they
+  // free, such as a std::pmr::unsynchronized_pool_resource.
+std::pmr::memory_resource* gameMemory();
+
+class ArenaScope
+{
+  public:
+    explicit ArenaScope(std::pmr::memory_resource& memory);
+    ~ArenaScope();
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+  private:
+    std::pmr::memory_resource* m_outer;
+};
+
+  // Classes deriving from ArenaObject are created with new and delete as
+  // usual, but their memory comes from gameMemory().
+class ArenaObject
+{
+  public:
+    static void* operator new(size_t size);
+    static void operator delete(void* p, size_t size);
+};
+
+#endif // ARENA_INCLUDED
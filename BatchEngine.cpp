@@ -0,0 +1,504 @@
+#include "BatchEngine.h"
+#include "Game.h"
+#include "GameObserver.h"
+#include "Board.h"
+#include "Player.h"
+#include "DensityMap.h"
+#include "PlacementKernels.h"
+#include "globals.h"
+#include <string>
+#include <vector>
+#include <random>
+#include <cstring>
+using namespace std;
+
+  // The index of the n-th (from 0) cell set in m
+static int nthCell(CellMask m, int n)
+{
+    for ( int i = 0; i < n; i++)
+        m &= m - 1;
+    uint64_t low = uint64_t(m);
+    return low != 0 ? __builtin_ctzll(low) : 64 + __builtin_ctzll(uint64_t(m >> 64));
+}
+
+  // The cells of a ship of the given length whose top or left end is cell 0
+static CellMask runMask(int length, int step)
+{
+    CellMask run = 0;
+    for ( int i = 0; i < length; i++)
+        run |= CellMask(1) << (i * step);
+    return run;
+}
+
+static CellMask placementStartsIn(const BoardGeometry& geometry, CellMask usable, int length, Direction dir)
+{
+    int step = geometry.step(dir);
+    CellMask starts = usable & geometry.starts(dir, length);
+    for ( int i = 1; i < length && starts != 0; i++)
+        starts &= usable >> (i * step);
+    return starts;
+}
+
+  // SlotMasks::SLOT_VECTOR slots' words, worked on together: one AVX2
+  // instruction, or two SSE2 ones, per operation
+typedef uint64_t SlotWords __attribute__((vector_size(8 * SlotMasks::SLOT_VECTOR)));
+
+  // placementStartsIn for n slots (a multiple of SLOT_VECTOR) at once:
+  // outLo/outHi[slot] get the starts on usableLo/usableHi[slot]
+static void placementStartsBatch(const uint64_t* usableLo, const uint64_t* usableHi, int n,
+                                 CellMask startMask, int length, int step,
+                                 uint64_t* outLo, uint64_t* outHi)
+{
+    const uint64_t maskLo = uint64_t(startMask);
+    const uint64_t maskHi = uint64_t(startMask >> 64);
+    for ( int s = 0; s < n; s += SlotMasks::SLOT_VECTOR)
+    {
+        SlotWords lo;
+        SlotWords hi;
+        memcpy(&lo, usableLo + s, sizeof(lo));
+        memcpy(&hi, usableHi + s, sizeof(hi));
+        SlotWords startsLo = lo & maskLo;
+        SlotWords startsHi = hi & maskHi;
+        for ( int i = 1; i < length; i++)
+        {
+            int shift = i * step;
+            if ( shift >= 128 )
+                startsLo = startsHi = startsLo ^ startsLo;
+            else if ( shift >= 64 )
+            {
+                startsLo &= hi >> (shift - 64);
+                startsHi ^= startsHi;
+            }
+            else
+            {
+                startsLo &= (lo >> shift) | (hi << (64 - shift));
+                startsHi &= hi >> shift;
+            }
+        }
+        memcpy(outLo + s, &startsLo, sizeof(startsLo));
+        memcpy(outHi + s, &startsHi, sizeof(startsHi));
+    }
+}
+
+//******************** BoardGeometry **********************************
+
+BoardGeometry::BoardGeometry(int nRows, int nCols)
+ : m_rows(nRows), m_cols(nCols), m_all(0),
+   m_starts { pmr::vector<CellMask>(gameMemory()), pmr::vector<CellMask>(gameMemory()) }
+{
+    if ( nRows * nCols > 128 )
+        return;
+    for ( int cell = 0; cell < nRows * nCols; cell++)
+        m_all |= CellMask(1) << cell;
+    int maxLength = (nRows > nCols ? nRows : nCols);
+    for ( int d = 0; d < 2; d++)
+        m_starts[d].assign(maxLength + 1, 0);
+    for ( int length = 1; length <= maxLength; length++)
+        for ( int r = 0; r < nRows; r++)
+            for ( int c = 0; c < nCols; c++)
+            {
+                if ( c + length <= nCols )
+                    m_starts[HORIZONTAL][length] |= CellMask(1) << (r * nCols + c);
+                if ( r + length <= nRows )
+                    m_starts[VERTICAL][length] |= CellMask(1) << (r * nCols + c);
+            }
+}
+
+//******************** BatchBoards ************************************
+
+BatchBoards::BatchBoards(const Game& g, int nSlots)
+ : m_geometry(g.rows(), g.cols()), m_nShips(g.nShips()), m_lengths(gameMemory()),
+   m_afloat(nSlots), m_shots(nSlots), m_ships(nSlots * g.nShips(), 0, gameMemory())
+{
+    for ( int i = 0; i < m_nShips; i++)
+        m_lengths.push_back(g.shipLength(i));
+}
+
+void BatchBoards::setFleet(int slot, const Board& b)
+{
+    CellMask* ships = &m_ships[slot * m_nShips];
+    CellMask taken = 0;
+    for ( int s = 0; s < m_nShips; s++)
+    {
+        Point topOrLeft;
+        Direction dir = HORIZONTAL;
+        b.shipPlacement(s, topOrLeft, dir);
+        ships[s] = runMask(m_lengths[s], m_geometry.step(dir)) << (topOrLeft.r * m_geometry.cols() + topOrLeft.c);
+        taken |= ships[s];
+    }
+    m_afloat.set(slot, taken);
+    m_shots.set(slot, 0);
+}
+
+void BatchBoards::attack(const pmr::vector<char>& active, const pmr::vector<int>& cells, BatchShots& shots)
+{
+    for ( int slot = 0; slot < active.size(); slot++)
+    {
+        if ( !active[slot] )
+            continue;
+        int cell = cells[slot];
+        shots.hit[slot] = 0;
+        shots.sunk[slot] = -1;
+        CellMask bit = CellMask(1) << (cell & 127);
+        CellMask shot = m_shots.get(slot);
+        if ( cell < 0 || cell >= m_geometry.cells() || (shot & bit) != 0 )
+        {
+            shots.valid[slot] = 0;
+            continue;
+        }
+        shots.valid[slot] = 1;
+        m_shots.set(slot, shot | bit);
+        CellMask afloat = m_afloat.get(slot);
+        if ( (afloat & bit) == 0 )
+            continue;
+        shots.hit[slot] = 1;
+        m_afloat.set(slot, afloat & ~bit);
+        CellMask* ships = &m_ships[slot * m_nShips];
+        for ( int s = 0; s < m_nShips; s++)
+        {
+            if ( ships[s] & bit )
+            {
+                ships[s] &= ~bit;
+                if ( ships[s] == 0 )
+                    shots.sunk[slot] = s;
+                break;
+            }
+        }
+    }
+}
+
+//******************** BatchAwfulAttacker *****************************
+
+  // AwfulPlayer's attack: every cell in turn, from the last backwards
+class BatchAwfulAttacker : public BatchAttacker
+{
+  public:
+    BatchAwfulAttacker(const Game& g, int nSlots)
+     : m_cells(g.rows() * g.cols()), m_next(nSlots, 0, gameMemory())
+    {}
+    virtual void reset(int slot) { m_next[slot] = m_cells - 1; }
+    virtual void recommendAttacks(const pmr::vector<char>& active, pmr::vector<int>& cells,
+                                  pmr::vector<mt19937>& rngs);
+    virtual void recordAttackResults(const pmr::vector<char>&, const pmr::vector<int>&,
+                                     const BatchShots&) {}
+
+  private:
+    int m_cells;
+    pmr::vector<int> m_next;
+};
+
+void BatchAwfulAttacker::recommendAttacks(const pmr::vector<char>& active, pmr::vector<int>& cells,
+                                          pmr::vector<mt19937>&)
+{
+    for ( int slot = 0; slot < active.size(); slot++)
+    {
+        if ( !active[slot] )
+            continue;
+        cells[slot] = m_next[slot];
+        m_next[slot] = (m_next[slot] == 0 ? m_cells - 1 : m_next[slot] - 1);
+    }
+}
+
+//******************** BatchDensityAttacker ***************************
+
+  // GoodPlayer's DENSITY policy (see DensityMap) for a whole batch.  The
+  // placements of every ship length are found for all slots together, a
+  // word of each slot at a time; each slot's scores are then counted with
+  // the coverage kernels and its best unshot cell taken.
+class BatchDensityAttacker : public BatchAttacker
+{
+  public:
+    BatchDensityAttacker(const Game& g, int nSlots);
+    virtual void reset(int slot);
+    virtual void recommendAttacks(const pmr::vector<char>& active, pmr::vector<int>& cells,
+                                  pmr::vector<mt19937>& rngs);
+    virtual void recordAttackResults(const pmr::vector<char>& active, const pmr::vector<int>& cells,
+                                     const BatchShots& shots);
+
+  private:
+    BoardGeometry m_geometry;
+    int m_nSlots;
+    pmr::vector<int> m_lengths;        // the distinct ship lengths
+    pmr::vector<int> m_lengthOf;       // index into m_lengths, by shipId
+    pmr::vector<int> m_fleet;          // how many ships have each length
+    pmr::vector<int> m_afloat;         // ships of each length not sunk, m_lengths.size() per slot
+    SlotMasks m_shots;                 // cells attacked
+    SlotMasks m_hits;                  // 'X': hit, and not known to be part of a sunk ship
+    SlotMasks m_blocked;               // 'o' and 'S': no ship afloat can cover them
+    SlotMasks m_usable;                // scratch: not blocked
+    pmr::vector<uint64_t> m_startsLo;  // scratch: starts for each length and direction, by padded slot
+    pmr::vector<uint64_t> m_startsHi;
+
+    void markSunkShip(int slot, int cell, int length);
+};
+
+BatchDensityAttacker::BatchDensityAttacker(const Game& g, int nSlots)
+ : m_geometry(g.rows(), g.cols()), m_nSlots(nSlots), m_lengths(gameMemory()),
+   m_lengthOf(gameMemory()), m_fleet(gameMemory()), m_afloat(gameMemory()),
+   m_shots(nSlots), m_hits(nSlots), m_blocked(nSlots), m_usable(nSlots),
+   m_startsLo(gameMemory()), m_startsHi(gameMemory())
+{
+    for ( int s = 0; s < g.nShips(); s++)
+    {
+        int length = g.shipLength(s);
+        int i;
+        for ( i = 0; i < m_lengths.size() && m_lengths[i] != length; i++)
+            ;
+        if ( i == m_lengths.size() )
+        {
+            m_lengths.push_back(length);
+            m_fleet.push_back(0);
+        }
+        m_fleet[i]++;
+        m_lengthOf.push_back(i);
+    }
+    m_afloat.assign(nSlots * m_lengths.size(), 0);
+    m_startsLo.assign(2 * m_lengths.size() * SlotMasks::padded(nSlots), 0);
+    m_startsHi.assign(2 * m_lengths.size() * SlotMasks::padded(nSlots), 0);
+}
+
+void BatchDensityAttacker::reset(int slot)
+{
+    for ( int i = 0; i < m_lengths.size(); i++)
+        m_afloat[slot * m_lengths.size() + i] = m_fleet[i];
+    m_shots.set(slot, 0);
+    m_hits.set(slot, 0);
+    m_blocked.set(slot, 0);
+}
+
+void BatchDensityAttacker::recommendAttacks(const pmr::vector<char>& active, pmr::vector<int>& cells,
+                                            pmr::vector<mt19937>& rngs)
+{
+    const int nLengths = m_lengths.size();
+    const int nPadded = m_usable.lo.size();
+    const uint64_t allLo = uint64_t(m_geometry.all());
+    const uint64_t allHi = uint64_t(m_geometry.all() >> 64);
+    for ( int s = 0; s < nPadded; s++)
+    {
+        m_usable.lo[s] = allLo & ~m_blocked.lo[s];
+        m_usable.hi[s] = allHi & ~m_blocked.hi[s];
+    }
+    for ( int i = 0; i < nLengths; i++)
+        for ( int d = 0; d < 2; d++)
+        {
+            int offset = (2 * i + d) * nPadded;
+            placementStartsBatch(m_usable.lo.data(), m_usable.hi.data(), nPadded,
+                                 m_geometry.starts(Direction(d), m_lengths[i]), m_lengths[i],
+                                 m_geometry.step(Direction(d)), &m_startsLo[offset], &m_startsHi[offset]);
+        }
+
+    CoverageCounts placements;
+    CoverageCounts hitCover;
+    for ( int slot = 0; slot < m_nSlots; slot++)
+    {
+        if ( !active[slot] )
+            continue;
+        clearCoverage(placements);
+        clearCoverage(hitCover);
+        CellMask hits = m_hits.get(slot);
+        for ( int i = 0; i < nLengths; i++)
+        {
+            int weight = m_afloat[slot * nLengths + i];
+            if ( weight == 0 )
+                continue;
+            int length = m_lengths[i];
+            for ( int d = 0; d < 2; d++)
+            {
+                int at = (2 * i + d) * nPadded + slot;
+                CellMask starts = (CellMask(m_startsHi[at]) << 64) | m_startsLo[at];
+                int step = m_geometry.step(Direction(d));
+                addCoverage(placements, starts, length, step, weight);
+                for ( int j = 0; hits != 0 && j < length; j++)
+                    addCoverage(hitCover, starts & (hits >> (j * step)), length, step, weight);
+            }
+        }
+
+          // The best unshot cell, ties broken at random as DensityMap does
+        int best = -1;
+        long long bestScore = 0;
+        int ties = 0;
+        for ( CellMask unshot = m_geometry.all() & ~m_shots.get(slot); unshot != 0; unshot &= unshot - 1)
+        {
+            int cell = nthCell(unshot, 0);
+            long long score = placements.n[cell] + DensityMap::HIT_WEIGHT * hitCover.n[cell];
+            if ( best == -1 || score > bestScore )
+            {
+                best = cell;
+                bestScore = score;
+                ties = 1;
+            }
+            else if ( score == bestScore && uniform_int_distribution<>(0, ties++)(rngs[slot]) == 0 )
+                best = cell;
+        }
+        cells[slot] = (best == -1 ? 0 : best);
+    }
+}
+
+void BatchDensityAttacker::recordAttackResults(const pmr::vector<char>& active, const pmr::vector<int>& cells,
+                                               const BatchShots& shots)
+{
+    for ( int slot = 0; slot < m_nSlots; slot++)
+    {
+        if ( !active[slot] || !shots.valid[slot] )
+            continue;
+        CellMask bit = CellMask(1) << cells[slot];
+        m_shots.set(slot, m_shots.get(slot) | bit);
+        if ( shots.hit[slot] )
+            m_hits.set(slot, m_hits.get(slot) | bit);
+        else
+            m_blocked.set(slot, m_blocked.get(slot) | bit);
+        int shipId = shots.sunk[slot];
+        if ( shipId >= 0 )
+        {
+            m_afloat[slot * m_lengths.size() + m_lengthOf[shipId]]--;
+            markSunkShip(slot, cells[slot], m_lengths[m_lengthOf[shipId]]);
+        }
+    }
+}
+
+  // As ::markSunkShip: if the hits leave only one run of length cells
+  // through cell, those cells are the sunk ship and no longer hits
+void BatchDensityAttacker::markSunkShip(int slot, int cell, int length)
+{
+    CellMask hits = m_hits.get(slot);
+    int found = 0;
+    CellMask ship = 0;
+    for ( int d = 0; d < 2; d++)
+    {
+        int step = m_geometry.step(Direction(d));
+        CellMask starts = placementStartsIn(m_geometry, hits, length, Direction(d));
+        for ( int i = 0; i < length; i++)
+        {
+            int start = cell - i * step;
+            if ( start >= 0 && ((starts >> start) & 1) != 0 )
+            {
+                found++;
+                ship = runMask(length, step) << start;
+            }
+        }
+    }
+    if ( found != 1 )
+        return;
+    m_hits.set(slot, hits & ~ship);
+    m_blocked.set(slot, m_blocked.get(slot) | ship);
+}
+
+//******************** createBatchAttacker ****************************
+
+BatchAttacker* createBatchAttacker(const string& type, const Game& g, int nSlots)
+{
+    if ( g.rows() * g.cols() > 128 || nSlots < 1 )
+        return nullptr;
+    if ( type == "awful" )
+        return new BatchAwfulAttacker(g, nSlots);
+    if ( type == "density" )
+        return new BatchDensityAttacker(g, nSlots);
+    return nullptr;
+}
+
+//******************** playBatchedGames *******************************
+
+void playBatchedGames(const Game& g, const string& type1, const string& type2,
+                      int nSlots, unsigned long long seed, const function<bool(long long&)>& nextGame,
+                      long long& wins1, long long& wins2, long long& noResult, CountingGameObserver& counts)
+{
+      // Side i's attacker fires at the other side's boards
+    BatchAttacker* attackers[2] = { createBatchAttacker(type1, g, nSlots), createBatchAttacker(type2, g, nSlots) };
+      // and side i's placer places side i's fleets, one game at a time on
+      // its scratch board
+    Player* placers[2] = { createPlayer(type1, type1 + " 1", g), createPlayer(type2, type2 + " 2", g) };
+    Board scratch1(g);
+    Board scratch2(g);
+    Board* scratch[2] = { &scratch1, &scratch2 };
+    BatchBoards boards1(g, nSlots);
+    BatchBoards boards2(g, nSlots);
+    BatchBoards* boards[2] = { &boards1, &boards2 };
+    pmr::vector<mt19937> rngs(nSlots, gameMemory());
+    pmr::vector<char> active(nSlots, 0, gameMemory());
+    pmr::vector<char> toMove(nSlots, 0, gameMemory());   // side to move in each active slot
+    pmr::vector<char> moving(nSlots, 0, gameMemory());   // scratch: slots where one side moves
+    pmr::vector<int> cells(nSlots, 0, gameMemory());
+    BatchShots shots(nSlots);
+
+      // Put the next game in slot; false if there are none left
+    auto startGame = [&](int slot) {
+        long long k;
+        while ( nextGame(k) )
+        {
+            int first = (k % 2 == 1 ? 0 : 1);
+            seedRandom(seed, k);
+            bool placed = true;
+            for ( int i = 0; i < 2 && placed; i++)
+            {
+                int side = (i == 0 ? first : 1 - first);   // the first mover places first
+                scratch[side]->clear();
+                placers[side]->reset();
+                placed = placers[side]->placeShips(*scratch[side]);
+            }
+            if ( !placed )
+            {
+                noResult++;
+                continue;
+            }
+            boards1.setFleet(slot, scratch1);
+            boards2.setFleet(slot, scratch2);
+            SeedSequence seq(seed, k);
+            rngs[slot].seed(seq);
+            attackers[0]->reset(slot);
+            attackers[1]->reset(slot);
+            toMove[slot] = first;
+            return true;
+        }
+        return false;
+    };
+
+    int nActive = 0;
+    for ( int slot = 0; slot < nSlots; slot++)
+    {
+        active[slot] = startGame(slot);
+        nActive += active[slot];
+    }
+
+    while ( nActive > 0 )
+    {
+        for ( int side = 0; side < 2; side++)
+        {
+            for ( int slot = 0; slot < nSlots; slot++)
+                moving[slot] = active[slot] && toMove[slot] == side;
+            attackers[side]->recommendAttacks(moving, cells, rngs);
+            boards[1-side]->attack(moving, cells, shots);
+            attackers[side]->recordAttackResults(moving, cells, shots);
+
+            for ( int slot = 0; slot < nSlots; slot++)
+            {
+                if ( !moving[slot] )
+                    continue;
+                counts.turns++;
+                if ( !shots.valid[slot] )
+                    counts.wastedShots++;
+                else if ( shots.hit[slot] )
+                    counts.hits++;
+                else
+                    counts.misses++;
+                if ( shots.sunk[slot] >= 0 )
+                    counts.shipsDestroyed++;
+                toMove[slot] = 1 - side;
+                if ( !boards[1-side]->allShipsDestroyed(slot) )
+                    continue;
+
+                counts.games++;
+                if ( side == 0 )
+                    wins1++;
+                else
+                    wins2++;
+                active[slot] = startGame(slot);
+                nActive -= !active[slot];
+            }
+        }
+    }
+
+    delete attackers[0];
+    delete attackers[1];
+    delete placers[0];
+    delete placers[1];
+}
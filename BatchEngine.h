@@ -0,0 +1,134 @@
+#ifndef BATCHENGINE_INCLUDED
+#define BATCHENGINE_INCLUDED
+
+#include "FixedBoard.h"
+#include "Arena.h"
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+class Game;
+class Board;
+class CountingGameObserver;
+
+  // Headless play of many independent games in lockstep, for boards of at
+  // most 128 cells.  A batch has a number of slots, each holding one game;
+  // every step, each attacker chooses a shot for every slot in one call,
+  // all shots are resolved, and every attacker is told every result.  The
+  // boards and the attackers' knowledge are kept as struct-of-arrays, one
+  // array entry per slot, so the per-step work runs as loops over slots
+  // that handle several games per instruction.  Everything comes from
+  // gameMemory().
+  //
+  // Only the density attacker's placement starts are worked out across
+  // slots.  Its coverage counts and best-cell scan still run one slot at a
+  // time, awful has nothing to batch, and GoodPlayer's heuristic policy
+  // isn't batched at all.  So batching plays density games about twice as
+  // fast on one thread, not the order of magnitude it was meant to give.
+
+  // One CellMask per slot, as separate arrays of low and high words.  The
+  // arrays are padded to a whole number of SLOT_VECTORs.
+struct SlotMasks
+{
+    static const int SLOT_VECTOR = 4;
+
+    explicit SlotMasks(int nSlots)
+     : lo(padded(nSlots), 0, gameMemory()), hi(padded(nSlots), 0, gameMemory())
+    {}
+    static int padded(int nSlots) { return (nSlots + SLOT_VECTOR - 1) / SLOT_VECTOR * SLOT_VECTOR; }
+    CellMask get(int slot) const { return (CellMask(hi[slot]) << 64) | lo[slot]; }
+    void set(int slot, CellMask m) { lo[slot] = uint64_t(m); hi[slot] = uint64_t(m >> 64); }
+
+    std::pmr::vector<uint64_t> lo;
+    std::pmr::vector<uint64_t> hi;
+};
+
+  // The cells of a rows x cols board and, for each length and direction, the
+  // cells a ship can start on without running off it
+class BoardGeometry
+{
+  public:
+    BoardGeometry(int nRows, int nCols);
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+    int cells() const { return m_rows * m_cols; }
+    CellMask all() const { return m_all; }
+    int step(Direction dir) const { return dir == HORIZONTAL ? 1 : m_cols; }
+    CellMask starts(Direction dir, int length) const
+    {
+        return length < m_starts[dir].size() ? m_starts[dir][length] : 0;
+    }
+
+  private:
+    int m_rows;
+    int m_cols;
+    CellMask m_all;
+    std::pmr::vector<CellMask> m_starts[2];   // by length
+};
+
+  // The outcome of one step's shots, by slot
+struct BatchShots
+{
+    explicit BatchShots(int nSlots)
+     : valid(nSlots, 0, gameMemory()), hit(nSlots, 0, gameMemory()), sunk(nSlots, -1, gameMemory())
+    {}
+
+    std::pmr::vector<char> valid;
+    std::pmr::vector<char> hit;
+    std::pmr::vector<int> sunk;    // shipId sunk by the shot, or -1
+};
+
+  // The fleets of every slot's game on one side
+class BatchBoards
+{
+  public:
+    BatchBoards(const Game& g, int nSlots);
+      // Start a new game in slot with the fleet placed on b
+    void setFleet(int slot, const Board& b);
+      // Fire at cells[slot] in every active slot
+    void attack(const std::pmr::vector<char>& active, const std::pmr::vector<int>& cells, BatchShots& shots);
+    bool allShipsDestroyed(int slot) const { return m_afloat.lo[slot] == 0 && m_afloat.hi[slot] == 0; }
+
+  private:
+    BoardGeometry m_geometry;
+    int m_nShips;
+    std::pmr::vector<int> m_lengths;    // by shipId
+    SlotMasks m_afloat;                 // ship cells not hit yet
+    SlotMasks m_shots;                  // cells attacked so far
+    std::pmr::vector<CellMask> m_ships; // unhit cells of each ship, nShips per slot
+};
+
+  // An attacker playing every slot of a batch at once
+class BatchAttacker : public ArenaObject
+{
+  public:
+    virtual ~BatchAttacker() {}
+      // Forget what was learned in slot; a new game starts there
+    virtual void reset(int slot) = 0;
+      // Set cells[slot] to the cell to attack in every active slot, drawing
+      // any random choice for a slot from rngs[slot]
+    virtual void recommendAttacks(const std::pmr::vector<char>& active, std::pmr::vector<int>& cells,
+                                  std::pmr::vector<std::mt19937>& rngs) = 0;
+    virtual void recordAttackResults(const std::pmr::vector<char>& active, const std::pmr::vector<int>& cells,
+                                     const BatchShots& shots) = 0;
+};
+
+  // "awful" and "density" play as the players createPlayer makes of those
+  // types; nullptr for any other type, or a board of over 128 cells.
+BatchAttacker* createBatchAttacker(const std::string& type, const Game& g, int nSlots);
+
+  // Play games of type1 against type2 nSlots at a time until nextGame,
+  // which claims the index of the next game to start, returns false.  Game
+  // k lets type1 move first when k is odd.  Each side's fleet is placed by
+  // its type's own placeShips, seeded from (seed, k) just as an unbatched
+  // game k is, so both place the same fleets.  The attackers then draw
+  // their random choices from a generator seeded from (seed, k), so the
+  // game plays the same in whatever slot or thread it lands.  The results
+  // are added to wins1, wins2, noResult and counts.
+void playBatchedGames(const Game& g, const std::string& type1, const std::string& type2,
+                      int nSlots, unsigned long long seed, const std::function<bool(long long&)>& nextGame,
+                      long long& wins1, long long& wins2, long long& noResult, CountingGameObserver& counts);
+
+#endif // BATCHENGINE_INCLUDED
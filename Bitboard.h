@@ -0,0 +1,109 @@
+#ifndef BITBOARD_INCLUDED
+#define BITBOARD_INCLUDED
+
+#include "Arena.h"
+#include <cstdint>
+#include <vector>
+
+  // A set of board cells, one bit per cell; cell (r,c) of a board with
+  // nCols columns is bit r*nCols+c.  Sized when constructed, so it takes
+  // rows*cols/8 bytes whatever the board size, and runs of cells in a row
+  // are tested and changed a word at a time.  Its words come from
+  // gameMemory() (see Arena.h).
+class Bitboard
+{
+  public:
+    Bitboard() : m_words(gameMemory()), m_nBits(0) {}
+    explicit Bitboard(int nBits) : m_words((nBits + 63) / 64, 0, gameMemory()), m_nBits(nBits) {}
+    Bitboard(const Bitboard& other) : m_words(other.m_words, gameMemory()), m_nBits(other.m_nBits) {}
+    Bitboard(Bitboard&& other) = default;
+    Bitboard& operator=(const Bitboard& other) = default;
+    Bitboard& operator=(Bitboard&& other) = default;
+
+    int size() const { return m_nBits; }
+    bool test(int bit) const { return (m_words[bit >> 6] >> (bit & 63)) & 1; }
+    void set(int bit) { m_words[bit >> 6] |= uint64_t(1) << (bit & 63); }
+    void reset(int bit) { m_words[bit >> 6] &= ~(uint64_t(1) << (bit & 63)); }
+
+    void clear()
+    {
+        for ( int i = 0; i < m_words.size(); i++)
+            m_words[i] = 0;
+    }
+
+    int count() const
+    {
+        int n = 0;
+        for ( int i = 0; i < m_words.size(); i++)
+            n += __builtin_popcountll(m_words[i]);
+        return n;
+    }
+
+      // Is any bit in [first, first+n) set?
+    bool anyInRun(int first, int n) const
+    {
+        while ( n > 0 )
+        {
+            int offset = first & 63;
+            int take = 64 - offset < n ? 64 - offset : n;
+            if ( m_words[first >> 6] & runBits(offset, take) )
+                return true;
+            first += take;
+            n -= take;
+        }
+        return false;
+    }
+
+      // Is every bit in [first, first+n) set?
+    bool allInRun(int first, int n) const
+    {
+        while ( n > 0 )
+        {
+            int offset = first & 63;
+            int take = 64 - offset < n ? 64 - offset : n;
+            uint64_t bits = runBits(offset, take);
+            if ( (m_words[first >> 6] & bits) != bits )
+                return false;
+            first += take;
+            n -= take;
+        }
+        return true;
+    }
+
+    void setRun(int first, int n)
+    {
+        while ( n > 0 )
+        {
+            int offset = first & 63;
+            int take = 64 - offset < n ? 64 - offset : n;
+            m_words[first >> 6] |= runBits(offset, take);
+            first += take;
+            n -= take;
+        }
+    }
+
+    void resetRun(int first, int n)
+    {
+        while ( n > 0 )
+        {
+            int offset = first & 63;
+            int take = 64 - offset < n ? 64 - offset : n;
+            m_words[first >> 6] &= ~runBits(offset, take);
+            first += take;
+            n -= take;
+        }
+    }
+
+    const std::pmr::vector<uint64_t>& words() const { return m_words; }
+
+  private:
+    std::pmr::vector<uint64_t> m_words;
+    int m_nBits;
+
+    static uint64_t runBits(int offset, int n)
+    {
+        return (n == 64 ? ~uint64_t(0) : (uint64_t(1) << n) - 1) << offset;
+    }
+};
+
+#endif // BITBOARD_INCLUDED
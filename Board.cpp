@@ -1,20 +1,23 @@
 #include "Board.h"
 #include "Game.h"
+#include "Bitboard.h"
+#include "FixedBoard.h"
+#include "PlacementTable.h"
+#include "Arena.h"
 #include "globals.h"
 #include <iostream>
 #include <vector>
-#include <algorithm>
 using namespace std;
 
-class Ship{
-public:
-    Ship ( int id ): shipId (id) {}
-    vector<Point> unHitPts;  // get from Game::length
-    int shipId;
-};
-
+  // The board's cell sets are Bitboards sized to the game, plus one shipId
+  // per cell, so storage grows with rows*cols and checking a placement,
+  // resolving a shot, and noticing a sunk ship or a finished game never
+  // rescan the board or the fleet.  All of it comes from gameMemory().
+  // On a board of at most MAX_TABLE_CELLS cells the cell sets fit a
+  // CellMask, and a placement is looked up in its ship's PlacementTable and
+  // checked with one mask test.
 
-class BoardImpl
+class BoardImpl : public ArenaObject
 {
   public:
     BoardImpl(const Game& g);
@@ -26,274 +29,257 @@ class BoardImpl
     void display(bool shotsOnly) const;
     bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
     bool allShipsDestroyed() const;
-    ~BoardImpl();
+    void freeCells(Bitboard& cells) const;
+    bool shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const;
 
   private:
-      // TODO:  Decide what private members you need.  Here's one that's likely
-      //        to be useful:
+    struct ShipState {
+        bool placed;
+        Point topOrLeft;
+        Direction dir;
+        int unHitCells;
+    };
+
     const Game& m_game;
-    vector<Ship*> shippy;
-    char displayGrid[MAXROWS][MAXCOLS];
+    int m_rows;
+    int m_cols;
+    Bitboard m_occupied;              // cells covered by any ship
+    Bitboard m_blocked;               // cells made unavailable by block()
+    Bitboard m_shots;                 // cells attacked so far
+    Bitboard m_hits;                  // attacked cells that held a ship
+    pmr::vector<int> m_owner;         // shipId covering each cell; only meaningful where m_occupied is set
+    pmr::vector<ShipState> m_ships;   // by shipId
+    pmr::vector<const PlacementTable*> m_tables;   // by shipId; nullptr on big boards
+    int m_unHitCells;                 // over all placed ships
     
     //helper functions:
-    bool isValidPlacement( const Point& topOrLeft, const Direction& dir = HORIZONTAL, const int& length = 1) const;
-    bool addShipToBoard(const Point& topOrLeft, const Direction& dir, const int& shipId);
-    bool markOnBoard(const Point& topOrLeft, Ship* target, const Direction& dir, const char& replaceThat, const char& withThis, const int& length );
-    bool replace(const Point& pt, char oldVal, char newVal);
-    
-    bool shipIdTaken( const int& id ) const;
-    int isOccupiedBy(const Point& pt, Ship* target) const;
-    void deleteShip(vector<Ship*>::iterator itr);
+    int cellIndex(const Point& p) const { return p.r * m_cols + p.c; }
+    bool fits(const Point& topOrLeft, const Direction& dir, int shipId) const;
+    bool isValidPlacement(const Point& topOrLeft, const Direction& dir, const int& length) const;
+    bool isFree(const Point& topOrLeft, const Direction& dir, const int& length) const;
+    void mark(const Point& topOrLeft, const Direction& dir, const int& length, int shipId);
 };
 
-
-int BoardImpl::isOccupiedBy(const Point& pt, Ship* target) const
-{
-        for ( int j = 0; j < target->unHitPts.size(); j++)
-        {
-            if (target->unHitPts[j].r == pt.r && target->unHitPts[j].c == pt.c)
-                return j;
-        }
-    return -1;
-}
-
-bool BoardImpl::shipIdTaken( const int& id ) const
+BoardImpl::BoardImpl(const Game& g)
+ : m_game(g), m_rows(g.rows()), m_cols(g.cols()),
+   m_occupied(g.rows() * g.cols()), m_blocked(g.rows() * g.cols()),
+   m_shots(g.rows() * g.cols()), m_hits(g.rows() * g.cols()),
+   m_owner(g.rows() * g.cols(), gameMemory()), m_ships(g.nShips(), gameMemory()),
+   m_tables(gameMemory())
 {
-    for ( int i = 0; i< shippy.size(); i++)
-    {
-        if ( shippy[i]->shipId == id )
-            return true;
-    }
-    return false;
+    for ( int i = 0; i < g.nShips(); i++)
+        m_tables.push_back(PlacementTable::forShip(m_rows, m_cols, g.shipLength(i)));
+    clear();
 }
 
-
-bool lesserId( Ship* s1, Ship* s2)
+void BoardImpl::clear()
 {
-    return ( s1->shipId < s2->shipId );
+    m_occupied.clear();
+    m_blocked.clear();
+    m_shots.clear();
+    m_hits.clear();
+    for ( int i = 0; i < m_ships.size(); i++)
+        m_ships[i].placed = false;
+    m_unHitCells = 0;
 }
 
-bool BoardImpl::replace(const Point& pt, char oldVal, char newVal)
+void BoardImpl::block()
 {
-    if ( displayGrid[pt.r][pt.c] == oldVal )
-    {
-        displayGrid[pt.r][pt.c] = newVal;
-        return true;
-    }
-    return false;
+      // Block cells with 50% probability
+    for (int r = 0; r < m_rows; r++)
+        for (int c = 0; c < m_cols; c++)
+        {
+            if (randInt(2) == 0)
+            {
+                int i = cellIndex(Point(r,c));
+                if ( !m_occupied.test(i) )
+                    m_blocked.set(i);
+            }
+        }
 }
 
-BoardImpl::BoardImpl(const Game& g)
- : m_game(g)
+void BoardImpl::unblock()
 {
-    clear();
-    // This compiles, but may not be correct
+    m_blocked.clear();
 }
 
-void BoardImpl::clear()
+  // Whether shipId could be placed at topOrLeft going dir: on the board,
+  // and clear of every ship, blocked cell and shot
+bool BoardImpl::fits(const Point& topOrLeft, const Direction& dir, int shipId) const
 {
-    for ( int r = 0; r < MAXROWS; r++)
+    const PlacementTable* table = m_tables[shipId];
+    if ( table == nullptr )
     {
-        for ( int c = 0; c < MAXCOLS; c++)
-            displayGrid[r][c] = '.';
+        int length = m_game.shipLength(shipId);
+        return isValidPlacement(topOrLeft, dir, length) && isFree(topOrLeft, dir, length);
     }
+    if ( topOrLeft.r < 0 || topOrLeft.r >= m_rows || topOrLeft.c < 0 || topOrLeft.c >= m_cols )
+        return false;
+    if ( dir != HORIZONTAL && dir != VERTICAL )
+        return false;
+    int placement = table->at(cellIndex(topOrLeft), dir);
+    if ( placement == -1 )
+        return false;
+    CellMask taken = cellMask(m_occupied) | cellMask(m_blocked) | cellMask(m_shots);
+    return (taken & table->mask(placement)) == 0;
 }
 
-BoardImpl::~BoardImpl()
-{
-    while ( !shippy.empty() )
-        deleteShip(shippy.begin());
-}
-
-void BoardImpl::deleteShip(vector<Ship*>::iterator itr)
+bool BoardImpl::isValidPlacement(const Point& topOrLeft, const Direction& dir, const int& length) const
 {
-    delete *itr;
-    shippy.erase(itr);
+    if ( topOrLeft.r < 0 || topOrLeft.r >= m_rows || topOrLeft.c < 0 || topOrLeft.c >= m_cols )
+        return false;
+    switch (dir)
+    {
+        case HORIZONTAL:
+            return topOrLeft.c + length <= m_cols;
+        case VERTICAL:
+            return topOrLeft.r + length <= m_rows;
+    }
+    return false;
 }
 
-
-void BoardImpl::block()
+bool BoardImpl::isFree(const Point& topOrLeft, const Direction& dir, const int& length) const
 {
-      // Block cells with 50% probability
-    for (int r = 0; r < m_game.rows(); r++)
-        for (int c = 0; c < m_game.cols(); c++)
-        {
-            if (randInt(2) == 0)
+    int first = cellIndex(topOrLeft);
+    switch (dir)
+    {
+        case HORIZONTAL:
+            return !m_occupied.anyInRun(first, length) && !m_blocked.anyInRun(first, length) &&
+                   !m_shots.anyInRun(first, length);
+        case VERTICAL:
+            for ( int i = first; i < first + length * m_cols; i += m_cols)
             {
-                displayGrid[r][c] = '#';
+                if ( m_occupied.test(i) || m_blocked.test(i) || m_shots.test(i) )
+                    return false;
             }
-        }
-    
+            return true;
+    }
+    return false;
 }
 
-void BoardImpl::unblock()
+void BoardImpl::mark(const Point& topOrLeft, const Direction& dir, const int& length, int shipId)
 {
-    for (int r = 0; r < m_game.rows(); r++)
-        for (int c = 0; c < m_game.cols(); c++)
+    int first = cellIndex(topOrLeft);
+    int step = dir == HORIZONTAL ? 1 : m_cols;
+    for ( int i = 0; i < length; i++)
+    {
+        int cell = first + i * step;
+        if ( shipId == -1 )
+            m_occupied.reset(cell);
+        else
         {
-            if ( displayGrid[r][c] == '#' )
-                displayGrid[r][c] = '.';
+            m_occupied.set(cell);
+            m_owner[cell] = shipId;
         }
+    }
 }
 
 bool BoardImpl::placeShip(Point topOrLeft, int shipId, Direction dir)
 {
     if ( shipId >= m_game.nShips() || shipId < 0 )
         return false;
-    if ( shipIdTaken(shipId))
-        return false;
-    if ( !isValidPlacement(topOrLeft, dir, m_game.shipLength(shipId)))
+    if ( m_ships[shipId].placed )
         return false;
-    
-    if ( !addShipToBoard(topOrLeft, dir, shipId) )  // checks for overlap with blocks and with other ships
-    {
+    int length = m_game.shipLength(shipId);
+    if ( !fits(topOrLeft, dir, shipId) )   // off the board, or overlaps a block or another ship
         return false;
-    }
 
-    std::sort(shippy.begin(), shippy.end(), lesserId);   // sorts by id so correct ship can be accessed at vector[ID]
+    mark(topOrLeft, dir, length, shipId);
+    m_ships[shipId] = ShipState { true, topOrLeft, dir, length };
+    m_unHitCells += length;
     return true;
 }
 
 bool BoardImpl::unplaceShip(Point topOrLeft, int shipId, Direction dir)
 {
-    if ( !shipIdTaken(shipId))
+    if ( shipId >= m_game.nShips() || shipId < 0 )
         return false;
-    
-    vector<Ship*>::iterator p;
-    for ( p = shippy.begin(); (*p)->shipId != shipId; p++) ;
-    
-    if ( !markOnBoard(topOrLeft, *p, dir, m_game.shipSymbol(shipId), '.', m_game.shipLength(shipId)) )
-       return false;
-    
-    deleteShip(p);
+    ShipState& ship = m_ships[shipId];
+    if ( !ship.placed || ship.topOrLeft.r != topOrLeft.r || ship.topOrLeft.c != topOrLeft.c || ship.dir != dir )
+        return false;
+
+    mark(topOrLeft, dir, m_game.shipLength(shipId), -1);
+    ship.placed = false;
+    m_unHitCells -= ship.unHitCells;
     return true;
 }
 
 void BoardImpl::display(bool shotsOnly) const
 {
     cout << "  ";
-    for ( int c = 0; c < m_game.cols(); c++)
+    for ( int c = 0; c < m_cols; c++)
         cout << c;
-    cout << endl;
-    for ( int r = 0; r < m_game.rows(); r++)
+    cout << '\n';
+    for ( int r = 0; r < m_rows; r++)
     {
         cout << r << ' ';
-        for ( int c = 0; c < m_game.cols(); c++)
+        for ( int c = 0; c < m_cols; c++)
         {
-            if ( shotsOnly )
-            {
-                if ( displayGrid[r][c] != '.' && displayGrid[r][c] != 'o' && displayGrid[r][c] != 'X')
-                    cout << '.';
-                else
-                    cout << displayGrid[r][c];
-            }
+            int i = cellIndex(Point(r,c));
+            if ( m_hits.test(i) )
+                cout << 'X';
+            else if ( m_shots.test(i) )
+                cout << 'o';
+            else if ( shotsOnly )
+                cout << '.';
+            else if ( m_occupied.test(i) )
+                cout << m_game.shipSymbol(m_owner[i]);
+            else if ( m_blocked.test(i) )
+                cout << '#';
             else
-                cout << displayGrid[r][c];
+                cout << '.';
         }
-        cout << endl;
+        cout << '\n';
     }
     
 }
 
 bool BoardImpl::attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId)
 {
-    if ( !isValidPlacement(p) )
+    if ( p.r < 0 || p.r >= m_rows || p.c < 0 || p.c >= m_cols )
         return false;
-    if ( displayGrid[p.r][p.c] == 'X' || displayGrid[p.r][p.c] == 'o')  ///previously attacked location
+    int i = cellIndex(p);
+    if ( m_shots.test(i) )   ///previously attacked location
         return false;
-    int hit;
-    shotHit = false;
+    m_shots.set(i);
+    shotHit = m_occupied.test(i);
     shipDestroyed = false;
-    displayGrid[p.r][p.c] = 'o';
-    for ( int i = 0; i < shippy.size(); i++)
+    if ( shotHit )
     {
-        hit = isOccupiedBy(p, shippy[i]);
-        if ( hit != -1 )
+        m_hits.set(i);
+        m_unHitCells--;
+        int id = m_owner[i];
+        if ( --m_ships[id].unHitCells == 0 )
         {
-            shippy[i]->unHitPts.erase(shippy[i]->unHitPts.begin() + hit);
-            displayGrid[p.r][p.c] = 'X';
-            shotHit = true;
-            
-            if ( shippy[i]->unHitPts.empty())
-            {
-                shipId = i;
-                shipDestroyed = true;
-            }
-            break;
+            shipId = id;
+            shipDestroyed = true;
         }
     }
-    
-    return true; // This compiles, but may not be correct
+    return true;
 }
 
 bool BoardImpl::allShipsDestroyed() const
 {
-   
-    for ( int i = 0; i < shippy.size(); i++)
-    {
-        if ( !shippy[i]->unHitPts.empty() )
-            return false;
-    }
-   
-    return true; // This compiles, but may not be correct
+    return m_unHitCells == 0;
 }
 
-bool BoardImpl::isValidPlacement( const Point& topOrLeft, const Direction& dir, const int& length) const
+void BoardImpl::freeCells(Bitboard& cells) const
 {
-    if ( topOrLeft.r > m_game.rows() || topOrLeft.c > m_game.cols() || topOrLeft.r < 0 || topOrLeft.c < 0)
-        return false;
-    
-    switch (dir)
+    cells = Bitboard(m_rows * m_cols);
+    cells.setRun(0, m_rows * m_cols);
+    for ( int i = 0; i < m_rows * m_cols; i++)
     {
-        case HORIZONTAL:
-            if ( topOrLeft.c + length > m_game.cols() )
-                return false;
-            break;
-        case VERTICAL:
-            if ( topOrLeft.r + length > m_game.rows() )
-                return false;
-            break;
+        if ( m_occupied.test(i) || m_blocked.test(i) || m_shots.test(i) )
+            cells.reset(i);
     }
-    return true;
 }
 
-bool BoardImpl::addShipToBoard(const Point& topOrLeft, const Direction& dir, const int& shipId)
+bool BoardImpl::shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const
 {
-    Ship* toAdd = new Ship ( shipId );
-    if ( !markOnBoard(topOrLeft, toAdd, dir, '.', m_game.shipSymbol(shipId), m_game.shipLength(shipId)) )
-    {
-        markOnBoard(topOrLeft, toAdd, dir,  m_game.shipSymbol(shipId), '.', m_game.shipLength(shipId));
-        delete toAdd;
+    if ( shipId < 0 || shipId >= m_ships.size() || !m_ships[shipId].placed )
         return false;
-    }
-
-    shippy.push_back(toAdd);
-    return true;
-}
-
-bool BoardImpl::markOnBoard(const Point& topOrLeft, Ship* target, const Direction& dir, const char& replaceThat, const char& withThis, const int& length )
-{
-    switch (dir)
-    {
-        case HORIZONTAL:
-            for ( int i = 0; i < length; i++)
-            {
-                if ( !replace(Point(topOrLeft.r,topOrLeft.c+i), replaceThat, withThis))
-                    return false;
-                if ( replaceThat == '.' )
-                    target->unHitPts.push_back(Point(topOrLeft.r, topOrLeft.c+i));
-            }
-            break;
-        case VERTICAL:
-            for ( int i = 0; i < length; i++)
-            {
-                if ( !replace(Point(topOrLeft.r+i,topOrLeft.c), replaceThat, withThis))
-                    return false;
-                if ( replaceThat == '.')
-                    target->unHitPts.push_back(Point(topOrLeft.r+i, topOrLeft.c));
-            }
-            break;
-    }
+    topOrLeft = m_ships[shipId].topOrLeft;
+    dir = m_ships[shipId].dir;
     return true;
 }
 
@@ -352,5 +338,12 @@ bool Board::allShipsDestroyed() const
     return m_impl->allShipsDestroyed();
 }
 
+void Board::freeCells(Bitboard& cells) const
+{
+    m_impl->freeCells(cells);
+}
 
-
+bool Board::shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const
+{
+    return m_impl->shipPlacement(shipId, topOrLeft, dir);
+}
@@ -5,6 +5,7 @@
 
 class Game;
 class BoardImpl;
+class Bitboard;
 
 class Board
 {  //// ship class, also vector/ struct.. ship class in game class?
@@ -19,6 +20,10 @@ class Board
     void display(bool shotsOnly) const;
     bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
     bool allShipsDestroyed() const;
+      // Set cells to the cells holding no ship, block or shot
+    void freeCells(Bitboard& cells) const;
+      // Where ship shipId is; false if it isn't placed
+    bool shipPlacement(int shipId, Point& topOrLeft, Direction& dir) const;
       // We prevent a Board object from being copied or assigned
     Board(const Board&) = delete;
     Board& operator=(const Board&) = delete;
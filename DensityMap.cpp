@@ -0,0 +1,200 @@
+#include "DensityMap.h"
+#include "Arena.h"
+#include "FixedBoard.h"
+#include "PlacementKernels.h"
+#include "PlacementPrior.h"
+#include "globals.h"
+#include <vector>
+using namespace std;
+
+DensityMap::DensityMap(int nRows, int nCols)
+ : m_rows(nRows), m_cols(nCols), m_across(nRows * nCols, gameMemory()),
+   m_down(nRows * nCols, gameMemory()),
+   m_diff((nRows > nCols ? nRows : nCols) + 1, gameMemory())
+{}
+
+void DensityMap::compute(const pmr::vector<char>& grid, const pmr::vector<int>& shipLengths)
+{
+    withBoardShape(m_rows, m_cols, [&](auto shape) { computeIn(shape, grid, shipLengths); });
+}
+
+void DensityMap::recount(const pmr::vector<char>& grid, const pmr::vector<int>& shipLengths, int cell)
+{
+    withBoardShape(m_rows, m_cols, [&](auto shape) { recountIn(shape, grid, shipLengths, cell); });
+}
+
+template<typename Shape>
+void DensityMap::computeIn(const Shape& shape, const pmr::vector<char>& grid,
+                           const pmr::vector<int>& shipLengths)
+{
+    for ( int r = 0; r < shape.rows(); r++)
+        addLine<Shape, HORIZONTAL>(shape, grid, shipLengths, r);
+    for ( int c = 0; c < shape.cols(); c++)
+        addLine<Shape, VERTICAL>(shape, grid, shipLengths, c);
+}
+
+template<typename Shape>
+void DensityMap::recountIn(const Shape& shape, const pmr::vector<char>& grid,
+                           const pmr::vector<int>& shipLengths, int cell)
+{
+    addLine<Shape, HORIZONTAL>(shape, grid, shipLengths, cell / shape.cols());
+    addLine<Shape, VERTICAL>(shape, grid, shipLengths, cell % shape.cols());
+}
+
+  // A placement covering k 'X' cells is counted once in placements and k
+  // times in hitCover, so a cell's score is placements + HIT_WEIGHT *
+  // hitCover, exactly as the line scan adds it up.  Ships of equal length
+  // are counted together.
+template<int Rows, int Cols>
+void DensityMap::computeIn(const FixedShape<Rows, Cols>& shape, const pmr::vector<char>& grid,
+                           const pmr::vector<int>& shipLengths)
+{
+    CellMask usable = 0;
+    CellMask hits = 0;
+    for ( int i = 0; i < shape.cells(); i++)
+    {
+        if ( grid[i] != 'o' && grid[i] != 'S' )
+            usable |= CellMask(1) << i;
+        if ( grid[i] == 'X' )
+            hits |= CellMask(1) << i;
+    }
+
+    CoverageCounts placements;
+    CoverageCounts hitCover;
+    clearCoverage(placements);
+    clearCoverage(hitCover);
+    int same;
+    for ( int s = 0; s < shipLengths.size(); s += same)
+    {
+        int length = shipLengths[s];
+        for ( same = 1; s + same < shipLengths.size() && shipLengths[s+same] == length; same++)
+            ;
+        if ( length > ShipMasks<Rows, Cols>::MAX_LENGTH )
+            continue;
+        for ( int d = 0; d < 2; d++)
+        {
+            Direction dir = Direction(d);
+            int step = (dir == HORIZONTAL ? 1 : Cols);
+            CellMask starts = placementStarts<Rows, Cols>(usable, length, dir);
+            addCoverage(placements, starts, length, step, same);
+            for ( int j = 0; hits != 0 && j < length; j++)
+                addCoverage(hitCover, starts & (hits >> (j * step)), length, step, same);
+        }
+    }
+
+    for ( int i = 0; i < shape.cells(); i++)
+    {
+        m_across[i] = placements.n[i] + HIT_WEIGHT * hitCover.n[i];
+        m_down[i] = 0;
+    }
+}
+
+  // Count the placements along row or column number line into m_across or
+  // m_down
+template<typename Shape, Direction dir>
+void DensityMap::addLine(const Shape& shape, const pmr::vector<char>& grid,
+                         const pmr::vector<int>& shipLengths, int line)
+{
+    const int first = (dir == HORIZONTAL ? line * shape.cols() : line);
+    const int step = (dir == HORIZONTAL ? 1 : shape.cols());
+    const int n = (dir == HORIZONTAL ? shape.cols() : shape.rows());
+    for ( int i = 0; i <= n; i++)
+        m_diff[i] = 0;
+
+    for ( int s = 0; s < shipLengths.size(); s++)
+    {
+        int length = shipLengths[s];
+        if ( length > n )
+            continue;
+        int blocked = 0;    // 'o' and 'S' cells in the current window
+        int hits = 0;       // 'X' cells in the current window
+        for ( int i = 0; i < n; i++)
+        {
+            char in = grid[first + i * step];
+            blocked += (in == 'o' || in == 'S');
+            hits += (in == 'X');
+            if ( i >= length )
+            {
+                char out = grid[first + (i - length) * step];
+                blocked -= (out == 'o' || out == 'S');
+                hits -= (out == 'X');
+            }
+            if ( i >= length - 1 && blocked == 0 )
+            {
+                long long weight = 1 + hits * HIT_WEIGHT;
+                m_diff[i - length + 1] += weight;
+                m_diff[i + 1] -= weight;
+            }
+        }
+    }
+
+    pmr::vector<long long>& part = (dir == HORIZONTAL ? m_across : m_down);
+    long long running = 0;
+    for ( int i = 0; i < n; i++)
+    {
+        running += m_diff[i];
+        part[first + i * step] = running;
+    }
+}
+
+int DensityMap::bestCell(const pmr::vector<char>& grid, const PlacementPrior* prior) const
+{
+    int best = -1;
+    long long bestScore = 0;
+    int ties = 0;
+    for ( int i = 0; i < grid.size(); i++)
+    {
+        if ( grid[i] != '.' )
+            continue;
+        long long s = score(i);
+        if ( prior != nullptr )
+            s *= prior->weight(i);
+        if ( best == -1 || s > bestScore )
+        {
+            best = i;
+            bestScore = s;
+            ties = 1;
+        }
+        else if ( s == bestScore && randInt(++ties) == 0 )
+            best = i;
+    }
+    return best;
+}
+
+bool markSunkShip(pmr::vector<char>& grid, int nRows, int nCols, int cell, int length)
+{
+    int row = cell / nCols;
+    int col = cell % nCols;
+    int found = 0;
+    int foundFirst = 0;
+    int foundStep = 0;
+
+      // Try every run of length cells through cell, across and then down
+    for ( int d = 0; d < 2; d++)
+    {
+        int step = (d == 0 ? 1 : nCols);
+        int pos = (d == 0 ? col : row);
+        int limit = (d == 0 ? nCols : nRows);
+        for ( int start = pos - length + 1; start <= pos; start++)
+        {
+            if ( start < 0 || start + length > limit )
+                continue;
+            int first = cell - (pos - start) * step;
+            bool allHit = true;
+            for ( int i = 0; i < length && allHit; i++)
+                allHit = grid[first + i * step] == 'X';
+            if ( allHit )
+            {
+                found++;
+                foundFirst = first;
+                foundStep = step;
+            }
+        }
+    }
+
+    if ( found != 1 )
+        return false;
+    for ( int i = 0; i < length; i++)
+        grid[foundFirst + i * foundStep] = 'S';
+    return true;
+}
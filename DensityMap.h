@@ -0,0 +1,77 @@
+#ifndef DENSITYMAP_INCLUDED
+#define DENSITYMAP_INCLUDED
+
+#include "globals.h"
+#include "FixedBoard.h"
+#include <vector>
+#include <memory_resource>
+
+  // An attacker's knowledge of the opponent's board, one char per cell, row
+  // by row:
+  //   '.'  not attacked yet
+  //   'o'  attacked and missed
+  //   'X'  hit a ship that is not known to be sunk
+  //   'S'  hit a ship known to be sunk
+  //
+  // DensityMap scores every '.' cell by the placements of the ships still
+  // afloat that cover it.  A placement may not touch 'o' or 'S' cells; one
+  // that covers k 'X' cells counts 1 + k*HIT_WEIGHT, so once something has
+  // been hit, the cells that could finish it dominate.  Each placement adds
+  // its weight to a difference array, so a full recompute is
+  // O(rows*cols*ships) regardless of ship length.  A cell's score is the sum
+  // of what its row and its column add, kept apart, so after a shot that
+  // sinks nothing, recount redoes just the two lines through it in
+  // O((rows+cols)*ships).  On the standard board the same scores are
+  // counted with whole-board masks instead (see PlacementKernels.h), and
+  // recount counts everything again.
+class PlacementPrior;
+
+class DensityMap
+{
+  public:
+    static const long long HIT_WEIGHT = 100;
+
+    DensityMap(int nRows, int nCols);
+    void compute(const std::pmr::vector<char>& grid, const std::pmr::vector<int>& shipLengths);
+      // Bring the scores up to date after a shot at cell changed grid, with
+      // shipLengths as they were when the scores were last computed
+    void recount(const std::pmr::vector<char>& grid, const std::pmr::vector<int>& shipLengths, int cell);
+    long long score(int cell) const { return m_across[cell] + m_down[cell]; }
+      // Index of a highest-scoring '.' cell (ties broken at random), or -1
+      // if no '.' cell is left.  With a prior, each score is first
+      // multiplied by the cell's weight.
+    int bestCell(const std::pmr::vector<char>& grid, const PlacementPrior* prior = nullptr) const;
+
+  private:
+    int m_rows;
+    int m_cols;
+    std::pmr::vector<long long> m_across;   // what each cell's row adds to its score
+    std::pmr::vector<long long> m_down;     // and what its column adds
+    std::pmr::vector<long long> m_diff;
+
+    template<typename Shape>
+    void computeIn(const Shape& shape, const std::pmr::vector<char>& grid,
+                   const std::pmr::vector<int>& shipLengths);
+    template<int Rows, int Cols>
+    void computeIn(const FixedShape<Rows, Cols>& shape, const std::pmr::vector<char>& grid,
+                   const std::pmr::vector<int>& shipLengths);
+    template<typename Shape>
+    void recountIn(const Shape& shape, const std::pmr::vector<char>& grid,
+                   const std::pmr::vector<int>& shipLengths, int cell);
+    template<int Rows, int Cols>
+    void recountIn(const FixedShape<Rows, Cols>& shape, const std::pmr::vector<char>& grid,
+                   const std::pmr::vector<int>& shipLengths, int)
+    {
+        computeIn(shape, grid, shipLengths);
+    }
+    template<typename Shape, Direction dir>
+    void addLine(const Shape& shape, const std::pmr::vector<char>& grid,
+                 const std::pmr::vector<int>& shipLengths, int line);
+};
+
+  // After a ship of the given length sinks at cell, mark its cells 'S' if
+  // the 'X' cells in grid leave only one way it could have lain.  Returns
+  // whether it did.
+bool markSunkShip(std::pmr::vector<char>& grid, int nRows, int nCols, int cell, int length);
+
+#endif // DENSITYMAP_INCLUDED
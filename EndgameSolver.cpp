@@ -0,0 +1,336 @@
+#include "EndgameSolver.h"
+#include "PlacementTable.h"
+#include "Arena.h"
+#include <vector>
+#include <algorithm>
+#include <climits>
+using namespace std;
+
+  // begin() gives up if more fleets than this agree with the grid, or if
+  // listing them takes more steps than this.  (It never tries a fleet of
+  // more than 64 ships.)
+const int MAX_FLEETS = 16;
+const long long ENUM_LIMIT = 20000;
+
+  // bestCell() gives up after searching this many positions
+const long long NODE_LIMIT = 500;
+
+  // Transposition table entries per thread; a power of 2
+const int TABLE_SIZE = 1 << 16;
+
+namespace
+{
+    struct TableEntry
+    {
+        uint64_t key;          // 0 if empty
+        int total;             // expected shots left, times the fleets agreeing
+        int best;              // the cell to shoot
+        long long nodes;       // positions searched to find it
+    };
+
+      // Kept on the heap, not in gameMemory(), since it outlives every game
+      // its thread plays.
+    TableEntry& tableSlot(uint64_t key)
+    {
+        thread_local vector<TableEntry> table(TABLE_SIZE, TableEntry { 0, 0, -1, 0 });
+        return table[key & (TABLE_SIZE - 1)];
+    }
+
+      // The Zobrist key of one feature of a position (splitmix64)
+    uint64_t featureKey(int kind, int cell, int length)
+    {
+        uint64_t x = (uint64_t(kind) << 48) ^ (uint64_t(cell) << 24) ^ uint64_t(length);
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+      // An answer, as answer() codes it: 0 miss, 1 hit, 1+length sunk
+    uint64_t answerKey(int cell, int code)
+    {
+        return featureKey('a', cell, code);
+    }
+
+    int popcount(CellMask m)
+    {
+        return __builtin_popcountll(uint64_t(m)) + __builtin_popcountll(uint64_t(m >> 64));
+    }
+
+    int lowestCell(CellMask m)
+    {
+        return uint64_t(m) != 0 ? __builtin_ctzll(uint64_t(m)) : 64 + __builtin_ctzll(uint64_t(m >> 64));
+    }
+}
+
+EndgameSolver::EndgameSolver(int nRows, int nCols)
+ : m_rows(nRows), m_cols(nCols), m_active(false), m_lengths(gameMemory()),
+   m_ships(gameMemory()), m_occupied(gameMemory()), m_live(gameMemory()), m_tooMany(0),
+   m_stack(gameMemory()), m_tables(gameMemory()),
+   m_blocked(0), m_hits(0), m_current(gameMemory()), m_shot(0), m_afloat(0), m_key(0), m_nodes(0), m_enumSteps(0)
+{
+      // Each position searched adds at most MAX_FLEETS fleets to m_stack,
+      // and a line of search shoots each cell at most once.
+    if ( boardFits() )
+        m_stack.reserve(MAX_FLEETS * (nRows * nCols + 1));
+}
+
+bool EndgameSolver::begin(const pmr::vector<char>& grid, const pmr::vector<int>& shipLengths)
+{
+    m_active = false;
+    if ( !boardFits() || shipLengths.empty() || shipLengths.size() > 64 )
+        return false;
+
+    m_blocked = 0;
+    m_hits = 0;
+    m_shot = 0;
+    for ( int i = 0; i < grid.size(); i++)
+    {
+        if ( grid[i] == 'X' )
+            m_hits |= CellMask(1) << i;
+        else if ( grid[i] != '.' )
+            m_blocked |= CellMask(1) << i;
+    }
+    m_shot = m_hits | m_blocked;
+
+    m_lengths.assign(shipLengths.begin(), shipLengths.end());
+    sort(m_lengths.begin(), m_lengths.end(), greater<int>());
+    int lengthLeft = 0;
+    m_tables.clear();
+    for ( int i = 0; i < m_lengths.size(); i++)
+    {
+        lengthLeft += m_lengths[i];
+        m_tables.push_back(PlacementTable::forShip(m_rows, m_cols, m_lengths[i]));
+    }
+
+    m_ships.clear();
+    m_occupied.clear();
+    m_current.resize(m_lengths.size());
+    m_enumSteps = 0;
+    uint64_t unplaced = (m_lengths.size() == 64 ? ~uint64_t(0) : (uint64_t(1) << m_lengths.size()) - 1);
+    if ( !coverHits(unplaced, 0, m_hits, lengthLeft) || m_occupied.empty() )
+        return false;
+
+    m_key = featureKey('B', m_rows, m_cols);
+    for ( int i = 0; i < grid.size(); i++)
+    {
+        if ( grid[i] != '.' )
+            m_key ^= featureKey(grid[i], i, 0);
+    }
+    for ( int i = 0; i < m_lengths.size(); i++)
+        m_key ^= featureKey('L', i, m_lengths[i]);
+    m_live.clear();
+    for ( int f = 0; f < m_occupied.size(); f++)
+        m_live.push_back(f);
+    m_afloat = m_lengths.size();
+    m_tooMany = MAX_FLEETS + 1;
+    m_active = true;
+    return true;
+}
+
+  // List the fleets that place the ships in unplaced on cells not in used
+  // and cover the hits in uncovered.  The lowest uncovered hit is covered
+  // first, by each ship that could (the first of several the same length),
+  // and the ships left over are then placed anywhere.  Returns false if
+  // there are too many fleets to list.
+bool EndgameSolver::coverHits(uint64_t unplaced, CellMask used, CellMask uncovered, int lengthLeft)
+{
+    if ( ++m_enumSteps > ENUM_LIMIT )
+        return false;
+    if ( uncovered == 0 )
+        return placeRest(0, 0, 0, unplaced, used);
+    if ( popcount(uncovered) > lengthLeft )
+        return true;
+
+    int hit = lowestCell(uncovered);
+    for ( int s = 0; s < m_lengths.size(); s++)
+    {
+        if ( ((unplaced >> s) & 1) == 0 ||
+             (s > 0 && m_lengths[s] == m_lengths[s-1] && ((unplaced >> (s-1)) & 1) != 0) )
+            continue;
+        const PlacementTable& table = *m_tables[s];
+        for ( const int* p = table.coverBegin(hit); p != table.coverEnd(hit); p++)
+        {
+            CellMask mask = table.mask(*p);
+            if ( (mask & used) != 0 || !legal(mask) )
+                continue;
+            m_current[s] = mask;
+            if ( !coverHits(unplaced & ~(uint64_t(1) << s), used | mask, uncovered & ~mask,
+                            lengthLeft - m_lengths[s]) )
+                return false;
+        }
+    }
+    return true;
+}
+
+  // Place the ships in unplaced from ship on anywhere not in used.  A ship
+  // as long as the one placed before it (prevLength) takes a placement after
+  // that one's (from), so each fleet is listed once.
+bool EndgameSolver::placeRest(int ship, int from, int prevLength, uint64_t unplaced, CellMask used)
+{
+    if ( ++m_enumSteps > ENUM_LIMIT )
+        return false;
+    while ( ship < m_lengths.size() && ((unplaced >> ship) & 1) == 0 )
+        ship++;
+    if ( ship == m_lengths.size() )
+    {
+        if ( m_occupied.size() == MAX_FLEETS )
+            return false;
+        m_ships.insert(m_ships.end(), m_current.begin(), m_current.end());
+        m_occupied.push_back(used);
+        return true;
+    }
+
+    const PlacementTable& table = *m_tables[ship];
+    for ( int k = (m_lengths[ship] == prevLength ? from : 0); k < table.size(); k++)
+    {
+        CellMask mask = table.mask(k);
+        if ( (mask & used) != 0 || !legal(mask) )
+            continue;
+        m_current[ship] = mask;
+        if ( !placeRest(ship + 1, k + 1, m_lengths[ship], unplaced, used | mask) )
+            return false;
+    }
+    return true;
+}
+
+  // What a shot at cell gets if the fleet is the one, with shot already
+  // shot: 0 miss, 1 hit, or 1 + the length of the ship it sinks
+int EndgameSolver::answer(int fleet, int cell, CellMask shot) const
+{
+    CellMask bit = CellMask(1) << cell;
+    if ( (m_occupied[fleet] & bit) == 0 )
+        return 0;
+    for ( int s = 0; s < m_lengths.size(); s++)
+    {
+        CellMask mask = m_ships[fleet * m_lengths.size() + s];
+        if ( (mask & bit) != 0 )
+            return (mask & ~shot) == bit ? 1 + m_lengths[s] : 1;
+    }
+    return 1;
+}
+
+void EndgameSolver::record(int cell, bool hit, int sunkLength)
+{
+    CellMask bit = CellMask(1) << cell;
+    if ( !m_active || (m_shot & bit) != 0 )
+        return;
+    int code = (!hit ? 0 : (sunkLength > 0 ? 1 + sunkLength : 1));
+    int n = 0;
+    for ( int i = 0; i < m_live.size(); i++)
+    {
+        if ( answer(m_live[i], cell, m_shot) == code )
+            m_live[n++] = m_live[i];
+    }
+    m_live.resize(n);
+    m_shot |= bit;
+    m_key ^= answerKey(cell, code);
+    if ( code > 1 )
+        m_afloat--;
+    if ( m_live.empty() )
+        m_active = false;
+}
+
+int EndgameSolver::bestCell()
+{
+    if ( !m_active || m_afloat == 0 || m_live.size() >= m_tooMany )
+        return -1;
+    m_stack.assign(m_live.begin(), m_live.end());
+    m_nodes = 0;
+    int best;
+    long long total = solve(0, m_live.size(), m_shot, m_afloat, m_key, best);
+    m_stack.clear();
+    if ( total < 0 )
+    {
+        m_tooMany = m_live.size();
+        return -1;
+    }
+    return best;
+}
+
+  // The least total, over the n fleets listed at m_stack[first], of the
+  // shots left to sink every ship afloat, setting best to the cell to shoot
+  // for it; -1 if the search grows past NODE_LIMIT.  Every fleet needs at
+  // least its unshot cells, so a cell covered by fewer fleets can't beat
+  // the best so far once the count it would save falls short.
+long long EndgameSolver::solve(int first, int n, CellMask shot, int afloat, uint64_t key, int& best)
+{
+    best = -1;
+    if ( afloat == 0 )
+        return 0;
+    TableEntry& slot = tableSlot(key);
+    if ( slot.key == key )
+    {
+        m_nodes += slot.nodes;
+        best = slot.best;
+        return m_nodes > NODE_LIMIT ? -1 : slot.total;
+    }
+    long long nodesBefore = m_nodes;
+    if ( ++m_nodes > NODE_LIMIT )
+        return -1;
+
+    int cover[128] = { 0 };
+    long long left = 0;
+    for ( int i = 0; i < n; i++)
+    {
+        CellMask open = m_occupied[m_stack[first + i]] & ~shot;
+        left += popcount(open);
+        for ( ; open != 0; open &= open - 1)
+            cover[lowestCell(open)]++;
+    }
+    int candidates[128];
+    int nCandidates = 0;
+    for ( int c = 0; c < m_rows * m_cols; c++)
+    {
+        if ( cover[c] > 0 )
+            candidates[nCandidates++] = c;
+    }
+    sort(candidates, candidates + nCandidates,
+         [&cover](int a, int b) { return cover[a] != cover[b] ? cover[a] > cover[b] : a < b; });
+
+    long long bestTotal = LLONG_MAX;
+    int codes[MAX_FLEETS];
+    for ( int k = 0; k < nCandidates; k++)
+    {
+        int cell = candidates[k];
+        if ( n + left - cover[cell] >= bestTotal )
+            break;
+
+          // Split the fleets by the answer they give, in order of answer
+        int maxCode = 0;
+        for ( int i = 0; i < n; i++)
+        {
+            codes[i] = answer(m_stack[first + i], cell, shot);
+            maxCode = max(maxCode, codes[i]);
+        }
+        long long total = n;
+        for ( int code = 0; code <= maxCode && total < bestTotal; code++)
+        {
+            int childFirst = m_stack.size();
+            for ( int i = 0; i < n; i++)
+            {
+                if ( codes[i] == code )
+                    m_stack.push_back(m_stack[first + i]);
+            }
+            int childN = m_stack.size() - childFirst;
+            if ( childN == 0 )
+                continue;
+            int childBest;
+            long long childTotal = solve(childFirst, childN, shot | (CellMask(1) << cell),
+                                         afloat - (code > 1 ? 1 : 0), key ^ answerKey(cell, code), childBest);
+            m_stack.resize(childFirst);
+            if ( childTotal < 0 )
+                return -1;
+            total += childTotal;
+        }
+        if ( total < bestTotal )
+        {
+            bestTotal = total;
+            best = cell;
+        }
+    }
+
+    TableEntry& entry = tableSlot(key);
+    entry = TableEntry { key, int(bestTotal), best, m_nodes - nodesBefore };
+    return bestTotal;
+}
@@ -0,0 +1,80 @@
+#ifndef ENDGAMESOLVER_INCLUDED
+#define ENDGAMESOLVER_INCLUDED
+
+#include "FixedBoard.h"
+#include <vector>
+#include <memory_resource>
+#include <cstdint>
+
+  // Plays the end of a game exactly.  begin() lists every fleet that agrees
+  // with an attacker's knowledge grid (see DensityMap.h): the ships still
+  // afloat on no 'o' or 'S' cell, covering every 'X' cell, none lying
+  // wholly on 'X' cells (it would have been reported sunk).  If there are
+  // few enough, each is taken as equally likely, and bestCell() searches
+  // every sequence of shots and answers (miss, hit, or sunk with a length)
+  // for the shot that leaves the fewest shots expected; record() then
+  // drops the fleets a shot's answer rules out.
+  //
+  // A position is identified by a Zobrist key: the XOR of a fixed random
+  // key for each non-'.' cell of the grid begin() saw and each ship length
+  // afloat then, and one for each answer recorded or searched since.
+  // Values found go in a bounded transposition table kept per thread, so
+  // the games a tournament worker plays share it, and a position seen in
+  // an earlier turn or game costs a lookup.  Expected shots are kept as
+  // totals over the fleets (integers), and a table entry remembers how many
+  // positions its search took, so whether a search fits its limit and which
+  // cell it picks don't depend on what the table already held: a game
+  // replays the same however many games its thread played before it.
+  //
+  // Boards of more than 128 cells are never solved.
+class PlacementTable;
+
+class EndgameSolver
+{
+  public:
+    EndgameSolver(int nRows, int nCols);
+      // Whether the board is small enough to solve at all
+    bool boardFits() const { return m_rows * m_cols <= 128; }
+      // Start solving the position in grid with ships of the given lengths
+      // afloat.  Returns false, leaving the solver inactive, if no fleet or
+      // too many fleets agree with it.
+    bool begin(const std::pmr::vector<char>& grid, const std::pmr::vector<int>& shipLengths);
+    bool active() const { return m_active; }
+    void end() { m_active = false; }
+      // The answer to a shot at cell: sunkLength is the length of the ship
+      // it sank, or 0.  The solver ends itself if no fleet agrees.
+    void record(int cell, bool hit, int sunkLength);
+      // The cell to shoot next, or -1 if the search would take too long.
+      // After giving up, it doesn't search again until fewer fleets agree.
+    int bestCell();
+
+  private:
+    int m_rows;
+    int m_cols;
+    bool m_active;
+    std::pmr::vector<int> m_lengths;          // afloat at begin(), longest first
+    std::pmr::vector<CellMask> m_ships;       // m_lengths.size() masks per fleet
+    std::pmr::vector<CellMask> m_occupied;    // all ships' cells, per fleet
+    std::pmr::vector<int> m_live;             // fleets agreeing with every answer
+    int m_tooMany;                            // live fleets when a search last gave up
+    std::pmr::vector<int> m_stack;            // fleet lists of the positions being searched
+    std::pmr::vector<const PlacementTable*> m_tables;   // per ship, while listing
+    CellMask m_blocked;                       // 'o' and 'S' cells, while listing
+    CellMask m_hits;                          // 'X' cells, while listing
+    std::pmr::vector<CellMask> m_current;     // the fleet being listed
+    CellMask m_shot;
+    int m_afloat;
+    uint64_t m_key;
+    long long m_nodes;
+    long long m_enumSteps;
+
+      // Whether a ship could lie on run: on no 'o' or 'S' cell, and not
+      // wholly on 'X' cells
+    bool legal(CellMask run) const { return (run & m_blocked) == 0 && (run & ~m_hits) != 0; }
+    bool coverHits(uint64_t unplaced, CellMask used, CellMask uncovered, int lengthLeft);
+    bool placeRest(int ship, int from, int prevLength, uint64_t unplaced, CellMask used);
+    int answer(int fleet, int cell, CellMask shot) const;
+    long long solve(int first, int n, CellMask shot, int afloat, uint64_t key, int& best);
+};
+
+#endif // ENDGAMESOLVER_INCLUDED
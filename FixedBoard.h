@@ -0,0 +1,130 @@
+#ifndef FIXEDBOARD_INCLUDED
+#define FIXEDBOARD_INCLUDED
+
+#include "globals.h"
+#include "Bitboard.h"
+
+  // Nearly every game is played on the standard 10x10 board with the
+  // standard fleet, so the engine's inner loops are written once as
+  // templates over a board shape and compiled twice: for StandardShape,
+  // whose dimensions are compile-time constants (loop bounds are known, so
+  // loops unroll and divisions become multiplications), and for
+  // RuntimeShape, which reads them at run time and handles every other size.
+  // withBoardShape picks between them once per call.
+
+const int STANDARD_ROWS = 10;
+const int STANDARD_COLS = 10;
+
+struct FleetShip
+{
+    int length;
+    char symbol;
+    const char* name;
+};
+
+constexpr FleetShip STANDARD_FLEET[] = {
+    { 5, 'A', "aircraft carrier" },
+    { 4, 'B', "battleship" },
+    { 3, 'D', "destroyer" },
+    { 3, 'S', "submarine" },
+    { 2, 'P', "patrol boat" }
+};
+constexpr int STANDARD_FLEET_SIZE = sizeof(STANDARD_FLEET) / sizeof(STANDARD_FLEET[0]);
+
+constexpr int standardFleetCells()
+{
+    int n = 0;
+    for ( int i = 0; i < STANDARD_FLEET_SIZE; i++)
+        n += STANDARD_FLEET[i].length;
+    return n;
+}
+static_assert(standardFleetCells() <= STANDARD_ROWS * STANDARD_COLS, "the standard fleet must fit");
+
+template<int Rows, int Cols>
+struct FixedShape
+{
+    static constexpr int rows() { return Rows; }
+    static constexpr int cols() { return Cols; }
+    static constexpr int cells() { return Rows * Cols; }
+    static constexpr bool isValid(int r, int c) { return r >= 0 && r < Rows && c >= 0 && c < Cols; }
+};
+
+class RuntimeShape
+{
+  public:
+    RuntimeShape(int nRows, int nCols) : m_rows(nRows), m_cols(nCols) {}
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+    int cells() const { return m_rows * m_cols; }
+    bool isValid(int r, int c) const { return r >= 0 && r < m_rows && c >= 0 && c < m_cols; }
+
+  private:
+    int m_rows;
+    int m_cols;
+};
+
+typedef FixedShape<STANDARD_ROWS, STANDARD_COLS> StandardShape;
+
+  // Call f with the shape of an nRows x nCols board and return what it does
+template<typename F>
+inline auto withBoardShape(int nRows, int nCols, F f) -> decltype(f(RuntimeShape(nRows, nCols)))
+{
+    if ( nRows == STANDARD_ROWS && nCols == STANDARD_COLS )
+        return f(StandardShape());
+    return f(RuntimeShape(nRows, nCols));
+}
+
+  // One bit per cell, for boards of at most 128 cells
+typedef unsigned __int128 CellMask;
+
+  // Compile-time cell masks for a Rows x Cols board: run[dir][length] is
+  // the cells a ship of that length covers if its top or left end is cell
+  // 0, and starts[dir][length] the cells where such a ship can start
+  // without running off the board.
+template<int Rows, int Cols>
+struct ShipMasks
+{
+    static_assert(Rows * Cols <= 128, "cell masks hold at most 128 cells");
+    static constexpr int MAX_LENGTH = Rows > Cols ? Rows : Cols;
+
+    CellMask all;
+    CellMask run[2][MAX_LENGTH + 1];
+    CellMask starts[2][MAX_LENGTH + 1];
+
+    constexpr ShipMasks() : all(0), run(), starts()
+    {
+        for ( int cell = 0; cell < Rows * Cols; cell++)
+            all |= CellMask(1) << cell;
+        for ( int length = 1; length <= MAX_LENGTH; length++)
+        {
+            for ( int i = 0; i < length; i++)
+            {
+                run[HORIZONTAL][length] |= CellMask(1) << i;
+                run[VERTICAL][length] |= CellMask(1) << (i * Cols);
+            }
+            for ( int r = 0; r < Rows; r++)
+                for ( int c = 0; c < Cols; c++)
+                {
+                    if ( c + length <= Cols )
+                        starts[HORIZONTAL][length] |= CellMask(1) << (r * Cols + c);
+                    if ( r + length <= Rows )
+                        starts[VERTICAL][length] |= CellMask(1) << (r * Cols + c);
+                }
+        }
+    }
+};
+
+template<int Rows, int Cols>
+constexpr ShipMasks<Rows, Cols> shipMasks {};
+
+  // The cells of a Bitboard of at most 128 cells
+inline CellMask cellMask(const Bitboard& b)
+{
+    const std::pmr::vector<uint64_t>& words = b.words();
+    CellMask mask = words.empty() ? 0 : words[0];
+    if ( words.size() > 1 )
+        mask |= CellMask(words[1]) << 64;
+    return mask;
+}
+
+#endif // FIXEDBOARD_INCLUDED
@@ -1,15 +1,18 @@
 #include "Game.h"
 #include "Board.h"
 #include "Player.h"
+#include "GameObserver.h"
+#include "Arena.h"
 #include "globals.h"
 #include <iostream>
 #include <string>
 #include <cstdlib>
 #include <cctype>
+#include <chrono>
 
 using namespace std;
 
-class GameImpl
+class GameImpl : public ArenaObject
 {
   public:
     GameImpl(int nRows, int nCols);
@@ -17,12 +20,12 @@ class GameImpl
     int cols() const;
     bool isValid(Point p) const;
     Point randomPoint() const;
-    bool addShip(int length, char symbol, string name);
+    bool addShip(int length, char symbol, const string& name);
     int nShips() const;
     int shipLength(int shipId) const;
     char shipSymbol(int shipId) const;
     string shipName(int shipId) const;
-    Player* play(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause);
+    Player* play(const Game& g, Player* p1, Player* p2, Board& b1, Board& b2, GameObserver& observer, bool shouldPause);
     ~GameImpl();
 private:
     int m_rows;
@@ -31,11 +34,11 @@ private:
     struct ShipType {
         int length;
         char symbol;
-        string nm;
+        pmr::string nm;
     };
-    vector<ShipType*> m_shipTypes;
+    pmr::vector<ShipType> m_shipTypes;
     
-    void takeTurn(Player* myTurn, Player* opponent, Board& opponentBoard, bool& shotHit, bool& shipDestroyed, int& shipId);
+    void takeTurn(Player* myTurn, Player* opponent, Board& opponentBoard, GameObserver& observer, bool& shotHit, bool& shipDestroyed, int& shipId);
     
 };
 
@@ -45,20 +48,13 @@ void waitForEnter()
     cin.ignore(10000, '\n');
 }
 
-GameImpl::GameImpl(int nRows, int nCols) : m_rows(nRows), m_cols(nCols), m_nShips(0)
+GameImpl::GameImpl(int nRows, int nCols) : m_rows(nRows), m_cols(nCols), m_nShips(0), m_shipTypes(gameMemory())
 {
     // This compiles but may not be correct
 }
 
 GameImpl::~GameImpl()
 {
-    ShipType* trash;
-    while ( !m_shipTypes.empty() )
-    {
-        trash = m_shipTypes.back();
-        m_shipTypes.pop_back();
-        delete trash;
-    }
 }
 
 int GameImpl::rows() const
@@ -81,10 +77,9 @@ Point GameImpl::randomPoint() const
     return Point(randInt(rows()), randInt(cols()));
 }
 
-bool GameImpl::addShip(int length, char symbol, string name)
+bool GameImpl::addShip(int length, char symbol, const string& name)
 {
-    ShipType* add = new ShipType { length, symbol, name };
-    m_shipTypes.push_back(add);
+    m_shipTypes.push_back(ShipType { length, symbol, pmr::string(name.data(), name.size(), m_shipTypes.get_allocator()) });
     m_nShips++;
     return true;  // This compiles but may not be correct
 }
@@ -96,42 +91,70 @@ int GameImpl::nShips() const
 
 int GameImpl::shipLength(int shipId) const
 {
-    return m_shipTypes[shipId]->length;  // This compiles but may not be correct
+    return m_shipTypes[shipId].length;  // This compiles but may not be correct
 }
 
 char GameImpl::shipSymbol(int shipId) const
 {
-    return m_shipTypes[shipId]->symbol;  // This compiles but may not be correct
+    return m_shipTypes[shipId].symbol;  // This compiles but may not be correct
 }
 
 string GameImpl::shipName(int shipId) const
 {
-    return m_shipTypes[shipId]->nm;  // This compiles but may not be correct
+    return string(m_shipTypes[shipId].nm);  // This compiles but may not be correct
+}
+
+  // Times one player call for the observer while in scope.  The clock is
+  // read only if the observer wants call times.
+class CallTimer
+{
+  public:
+    CallTimer(GameObserver& observer, const Player* player, PlayerCall call)
+     : m_observer(observer), m_player(player), m_call(call), m_timed(observer.timesCalls())
+    {
+        if ( m_timed )
+            m_start = chrono::steady_clock::now();
+    }
+    ~CallTimer()
+    {
+        if ( m_timed )
+            m_observer.callTimed(m_player, m_call,
+                chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - m_start).count());
+    }
+
+  private:
+    GameObserver& m_observer;
+    const Player* m_player;
+    PlayerCall m_call;
+    bool m_timed;
+    chrono::steady_clock::time_point m_start;
+};
+
+bool placeShipsTimed(Player* p, Board& b, GameObserver& observer)
+{
+    CallTimer timer(observer, p, PLACE_SHIPS);
+    return p->placeShips(b);
 }
 
-Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, bool shouldPause)
+Player* GameImpl::play(const Game& g, Player* p1, Player* p2, Board& b1, Board& b2, GameObserver& observer, bool shouldPause)
 {
-    if ( !p1->placeShips(b1) || !p2->placeShips(b2) )
+    if ( !placeShipsTimed(p1, b1, observer) || !placeShipsTimed(p2, b2, observer) )
         return nullptr;
+    observer.gameStarted(g, p1, b1, p2, b2);
     while (!b1.allShipsDestroyed() && !b2.allShipsDestroyed())
     {
         bool shotHit = false;
         bool shipDestroyed = false;
         int shipId = -1;
-        takeTurn(p1, p2, b2, shotHit, shipDestroyed, shipId);
+        takeTurn(p1, p2, b2, observer, shotHit, shipDestroyed, shipId);
         if ( b2.allShipsDestroyed() )
         {
-            cout << p1->name() << " wins!" << endl;
-            if ( p2->isHuman() )
-            {
-                cout << "Here's where " << p1->name() << "'s ships were:" << endl;
-                b1.display(false);
-            }
+            observer.gameOver(p1, p2, b1);
             return p1;
         }
         if ( shouldPause )
             waitForEnter();
-        takeTurn(p2, p1, b1, shotHit, shipDestroyed, shipId);
+        takeTurn(p2, p1, b1, observer, shotHit, shipDestroyed, shipId);
         
         if ( b1.allShipsDestroyed() )
             break;
@@ -140,42 +163,37 @@ Player* GameImpl::play(Player* p1, Player* p2, Board& b1, Board& b2, bool should
             waitForEnter();
 
     }
-    cout << p2->name() << " wins!" << endl;
-    if ( p1->isHuman() )
-    {
-        cout << "Here's where " << p2->name() << "'s ships were:" << endl;
-        b2.display(false);
-    }
-    return p2;  // This compiles but may not be correct
+    observer.gameOver(p2, p1, b2);
+    return p2;
 
 
 }
 
-void GameImpl::takeTurn( Player* myTurn, Player* opponent, Board& opponentBoard, bool& shotHit, bool& shipDestroyed, int& shipId )
+void GameImpl::takeTurn( Player* myTurn, Player* opponent, Board& opponentBoard, GameObserver& observer, bool& shotHit, bool& shipDestroyed, int& shipId )
 {
-    cout << myTurn->name() << "'s turn. Board for " << opponent->name() << ":" << endl;
-    opponentBoard.display( myTurn->isHuman() );
+    observer.turnStarted(myTurn, opponent, opponentBoard);
     
-    Point attackPt = myTurn->recommendAttack();
+    Point attackPt;
+    {
+        CallTimer timer(observer, myTurn, RECOMMEND_ATTACK);
+        attackPt = myTurn->recommendAttack();
+    }
     if (!opponentBoard.attack(attackPt, shotHit, shipDestroyed, shipId))
     {
-        cout << myTurn->name() << " wasted a shot at (" << attackPt.r << "," << attackPt.c << ")." << endl;
-        myTurn->recordAttackResult(attackPt, false, false, false, shipId);
+        observer.attackMade(myTurn, opponentBoard, attackPt, false, false, false, shipId);
+        {
+            CallTimer timer(observer, myTurn, RECORD_ATTACK_RESULT);
+            myTurn->recordAttackResult(attackPt, false, false, false, shipId);
+        }
         opponent->recordAttackByOpponent(attackPt);
     }
     else
     {
-        cout << myTurn->name() << " attacked (" << attackPt.r << "," << attackPt.c << ") and ";
-        if ( shotHit && !shipDestroyed )
-            cout << "hit something";
-        else if ( shotHit && shipDestroyed )
-            cout << "destroyed the " << shipName(shipId);
-        else
-            cout << "missed";
-        
-        cout <<", resulting in:" << endl;
-        opponentBoard.display( myTurn->isHuman() );
-        myTurn->recordAttackResult(attackPt, true, shotHit, shipDestroyed, shipId);
+        observer.attackMade(myTurn, opponentBoard, attackPt, true, shotHit, shipDestroyed, shipId);
+        {
+            CallTimer timer(observer, myTurn, RECORD_ATTACK_RESULT);
+            myTurn->recordAttackResult(attackPt, true, shotHit, shipDestroyed, shipId);
+        }
         opponent->recordAttackByOpponent(attackPt);
     }
 }
@@ -226,7 +244,7 @@ Point Game::randomPoint() const
     return m_impl->randomPoint();
 }
 
-bool Game::addShip(int length, char symbol, string name)
+bool Game::addShip(int length, char symbol, const string& name)
 {
     if (length < 1)
     {
@@ -294,11 +312,25 @@ string Game::shipName(int shipId) const
 }
 
 Player* Game::play(Player* p1, Player* p2, bool shouldPause)
+{
+    ConsoleGameObserver console;
+    return play(p1, p2, console, shouldPause);
+}
+
+Player* Game::play(Player* p1, Player* p2, GameObserver& observer, bool shouldPause)
 {
     if (p1 == nullptr  ||  p2 == nullptr  ||  nShips() == 0)
         return nullptr;
     Board b1(*this);
     Board b2(*this);
-    return m_impl->play(p1, p2, b1, b2, shouldPause);
+    return m_impl->play(*this, p1, p2, b1, b2, observer, shouldPause);
+}
+
+Player* Game::play(Player* p1, Player* p2, Board& b1, Board& b2,
+                   GameObserver& observer, bool shouldPause)
+{
+    if (p1 == nullptr  ||  p2 == nullptr  ||  nShips() == 0)
+        return nullptr;
+    return m_impl->play(*this, p1, p2, b1, b2, observer, shouldPause);
 }
 
@@ -7,6 +7,8 @@
 class Point;
 class Player;
 class GameImpl;
+class GameObserver;
+class Board;
 
 class Game
 {
@@ -17,12 +19,20 @@ class Game
     int cols() const;
     bool isValid(Point p) const;
     Point randomPoint() const;
-    bool addShip(int length, char symbol, std::string name);  
+    bool addShip(int length, char symbol, const std::string& name);  
     int nShips() const;
     int shipLength(int shipId) const;
     char shipSymbol(int shipId) const;
     std::string shipName(int shipId) const;
     Player* play(Player* p1, Player* p2, bool shouldPause = true);
+      // Same, but everything that happens is reported to observer instead
+      // of being printed.
+    Player* play(Player* p1, Player* p2, GameObserver& observer,
+                 bool shouldPause = false);
+      // Same, but on boards the caller keeps (b1 is p1's); they must be
+      // empty, as a new or cleared Board is.
+    Player* play(Player* p1, Player* p2, Board& b1, Board& b2,
+                 GameObserver& observer, bool shouldPause = false);
       // We prevent a Game object from being copied or assigned
     Game(const Game&) = delete;
     Game& operator=(const Game&) = delete;
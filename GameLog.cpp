@@ -0,0 +1,275 @@
+#include "GameLog.h"
+#include "Game.h"
+#include "Board.h"
+#include "Player.h"
+#include <iostream>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+using namespace std;
+
+static const char LOG_MAGIC[] = "BSHIPLG2";
+const int LOG_MAGIC_SIZE = 8;
+
+const size_t LOG_BUFFER_SIZE = 1 << 20;
+
+//******************** GameLogWriter functions ************************
+
+GameLogWriter::GameLogWriter(const string& path)
+ : m_buffer(LOG_BUFFER_SIZE), m_player1(nullptr), m_rows(0), m_cols(0), m_cellBytes(4),
+   m_winnerAt(0), m_nShotsAt(0), m_nShots(0), m_games(0)
+{
+    m_file = fopen(path.c_str(), "a+b");
+    if ( m_file == nullptr )
+    {
+        cout << "Could not open game log " << path << endl;
+        return;
+    }
+      // Appending to an existing log continues it, as long as it is in this
+      // format; a new one needs a header.
+    char magic[LOG_MAGIC_SIZE];
+    size_t nRead = fread(magic, 1, LOG_MAGIC_SIZE, m_file);
+    fseek(m_file, 0, SEEK_END);
+    if ( nRead == 0 )
+        fwrite(LOG_MAGIC, 1, LOG_MAGIC_SIZE, m_file);
+    else if ( memcmp(magic, LOG_MAGIC, LOG_MAGIC_SIZE) != 0 )
+    {
+        cout << path << " is not a game log in this format" << endl;
+        fclose(m_file);
+        m_file = nullptr;
+        return;
+    }
+    setvbuf(m_file, m_buffer.data(), _IOFBF, m_buffer.size());
+}
+
+GameLogWriter::~GameLogWriter()
+{
+    if ( m_file != nullptr )
+        fclose(m_file);
+}
+
+void GameLogWriter::put(uint32_t value, int nBytes)
+{
+    for ( int i = 0; i < nBytes; i++, value >>= 8)
+        m_record.push_back(value & 0xFF);
+}
+
+void GameLogWriter::patch(size_t at, uint32_t value, int nBytes)
+{
+    for ( int i = 0; i < nBytes; i++, value >>= 8)
+        m_record[at + i] = value & 0xFF;
+}
+
+void GameLogWriter::gameStarted(const Game& g, const Player* p1, const Board& b1,
+                                const Player* p2, const Board& b2)
+{
+    m_record.clear();
+    m_player1 = p1;
+    m_rows = g.rows();
+    m_cols = g.cols();
+    m_cellBytes = logCellBytes(m_rows, m_cols);
+    put(0, 4);                  // size, filled in by gameOver
+    put(m_rows, 2);
+    put(m_cols, 2);
+    put(g.nShips(), 2);
+    for ( int i = 0; i < g.nShips(); i++)
+    {
+        put(g.shipLength(i), 2);
+        put((unsigned char)(g.shipSymbol(i)), 1);
+    }
+    m_winnerAt = m_record.size();
+    put(0, 1);
+    const Board* boards[2] = { &b1, &b2 };
+    for ( int b = 0; b < 2; b++)
+    {
+        for ( int i = 0; i < g.nShips(); i++)
+        {
+            Point topOrLeft;
+            Direction dir = HORIZONTAL;
+            boards[b]->shipPlacement(i, topOrLeft, dir);
+            put(2 * (topOrLeft.r * m_cols + topOrLeft.c) + (dir == VERTICAL ? 1 : 0), m_cellBytes);
+        }
+    }
+    m_nShotsAt = m_record.size();
+    put(0, 4);
+    m_nShots = 0;
+}
+
+void GameLogWriter::attackMade(const Player* attacker, const Board&,
+                               Point p, bool validShot, bool shotHit,
+                               bool shipDestroyed, int)
+{
+    if ( m_record.empty() )
+        return;
+    uint32_t cell = (m_cellBytes == 2 ? NO_CELL_NARROW : NO_CELL);
+    if ( p.r >= 0 && p.r < m_rows && p.c >= 0 && p.c < m_cols )
+        cell = p.r * m_cols + p.c;
+    int flags = (attacker == m_player1 ? 0 : SHOT_BY_PLAYER2) |
+                (validShot ? SHOT_VALID : 0) | (shotHit ? SHOT_HIT : 0) |
+                (shipDestroyed ? SHOT_DESTROYED : 0);
+    put(cell << 4 | flags, m_cellBytes);
+    m_nShots++;
+}
+
+void GameLogWriter::gameOver(const Player* winner, const Player*, const Board&)
+{
+    if ( m_record.empty() || m_file == nullptr )
+        return;
+    patch(0, m_record.size() - 4, 4);
+    patch(m_winnerAt, winner == m_player1 ? 1 : 2, 1);
+    patch(m_nShotsAt, m_nShots, 4);
+    fwrite(m_record.data(), 1, m_record.size(), m_file);
+    m_record.clear();
+    m_games++;
+}
+
+//******************** GameRecord functions ***************************
+
+void GameRecord::placement(int player, int shipId, Point& topOrLeft, Direction& dir) const
+{
+    uint32_t position = get(winnerAt() + 1 + m_cellBytes * ((player - 1) * m_nShips + shipId), m_cellBytes);
+    int cell = position / 2;
+    topOrLeft = Point(cell / cols(), cell % cols());
+    dir = (position % 2 == 0 ? HORIZONTAL : VERTICAL);
+}
+
+bool GameRecord::shot(int k, Point& p, int& flags) const
+{
+    uint32_t value = get(shotsAt() + m_cellBytes * k, m_cellBytes);
+    flags = value & 15;
+    uint32_t cell = value >> 4;
+    if ( cell == (m_cellBytes == 2 ? NO_CELL_NARROW : NO_CELL) )
+        return false;
+    p = Point(cell / cols(), cell % cols());
+    return true;
+}
+
+//******************** GameLogReader functions ************************
+
+GameLogReader::GameLogReader()
+ : m_data(nullptr), m_size(0), m_pos(0)
+{}
+
+GameLogReader::~GameLogReader()
+{
+    close();
+}
+
+bool GameLogReader::open(const string& path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if ( fd < 0 )
+    {
+        cout << "Could not open game log " << path << endl;
+        return false;
+    }
+    struct stat info;
+    if ( fstat(fd, &info) != 0 || info.st_size < LOG_MAGIC_SIZE )
+    {
+        cout << path << " is not a game log" << endl;
+        ::close(fd);
+        return false;
+    }
+    void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);            // the mapping keeps the file
+    if ( data == MAP_FAILED )
+    {
+        cout << "Could not map game log " << path << endl;
+        return false;
+    }
+    madvise(data, info.st_size, MADV_SEQUENTIAL);
+    m_data = static_cast<const unsigned char*>(data);
+    m_size = info.st_size;
+    if ( memcmp(m_data, LOG_MAGIC, LOG_MAGIC_SIZE) != 0 )
+    {
+        cout << path << " is not a game log" << endl;
+        close();
+        return false;
+    }
+    m_pos = LOG_MAGIC_SIZE;
+    return true;
+}
+
+void GameLogReader::close()
+{
+    if ( m_data != nullptr )
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+    m_data = nullptr;
+    m_size = 0;
+    m_pos = 0;
+}
+
+bool GameLogReader::next(GameRecord& record)
+{
+    if ( m_data == nullptr || m_size - m_pos < 10 )
+        return false;
+    record.m_start = m_data + m_pos;
+    record.m_nShips = 0;
+    size_t size = 4 + size_t(record.get(0, 4));
+    if ( size > m_size - m_pos )
+        return false;
+      // Check the declared counts against the record size before trusting
+      // any offset computed from them.
+    int nShips = record.get(8, 2);
+    int cellBytes = logCellBytes(record.rows(), record.cols());
+    size_t shotsAt = 10 + 3 * size_t(nShips) + 1 + 2 * cellBytes * size_t(nShips) + 4;
+    if ( shotsAt > size )
+        return false;
+    record.m_nShips = nShips;
+    record.m_cellBytes = cellBytes;
+    if ( shotsAt + cellBytes * size_t(record.nShots()) != size || record.cols() == 0 ||
+         (record.winner() != 1 && record.winner() != 2) )
+        return false;
+    m_pos += size;
+    return true;
+}
+
+//******************** log summary ************************************
+
+bool reportGameLogs(const vector<string>& paths)
+{
+    long long games = 0;
+    long long wins[3] = { 0, 0, 0 };
+    long long shots[3] = { 0, 0, 0 };
+    long long hits[3] = { 0, 0, 0 };
+    bool allRead = true;
+    GameLogReader reader;
+    for ( int i = 0; i < paths.size(); i++)
+    {
+        if ( !reader.open(paths[i]) )
+        {
+            allRead = false;
+            continue;
+        }
+        GameRecord record;
+        while ( reader.next(record) )
+        {
+            games++;
+            wins[record.winner()]++;
+            for ( int k = 0; k < record.nShots(); k++)
+            {
+                Point p;
+                int flags;
+                record.shot(k, p, flags);
+                int player = (flags & SHOT_BY_PLAYER2 ? 2 : 1);
+                shots[player]++;
+                if ( flags & SHOT_HIT )
+                    hits[player]++;
+            }
+        }
+    }
+    cout << games << " games logged" << endl;
+    if ( games == 0 )
+        return allRead;
+    for ( int player = 1; player <= 2; player++)
+    {
+        cout << "  " << (player == 1 ? "first" : "second") << " mover won " << wins[player]
+             << " (" << 100.0 * wins[player] / games << "%), "
+             << double(shots[player]) / games << " shots and "
+             << double(hits[player]) / games << " hits per game" << endl;
+    }
+    return allRead;
+}
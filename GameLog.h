@@ -0,0 +1,148 @@
+#ifndef GAMELOG_INCLUDED
+#define GAMELOG_INCLUDED
+
+#include "GameObserver.h"
+#include "globals.h"
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+  // Game logs are a file header followed by one record per finished game,
+  // all integers little-endian:
+  //
+  //   file:    "BSHIPLG2"  record*
+  //   record:  u32 size of the rest of the record
+  //            u16 rows  u16 cols  u16 nShips
+  //            nShips x (u16 length  u8 symbol)
+  //            u8 winner (1 or 2)
+  //            2 x nShips x uN placement     player 1's fleet, then player 2's
+  //            u32 nShots
+  //            nShots x uN shot
+  //
+  // uN is u16 on boards of fewer than MAX_NARROW_CELLS cells, which covers
+  // any board a person would play on, and u32 on bigger ones.  Player 1 is
+  // whoever moved first.  A placement is 2*cell for a ship going across
+  // from cell, 2*cell+1 for one going down (cell is r*cols+c).  A shot is
+  // cell<<4 | flags, with flags SHOT_BY_PLAYER2, SHOT_VALID, SHOT_HIT and
+  // SHOT_DESTROYED; a shot off the board has cell NO_CELL (NO_CELL_NARROW
+  // in a u16).  A 10x10 game between the good and mediocre players comes
+  // to about 240 bytes.
+
+const int SHOT_BY_PLAYER2 = 1;
+const int SHOT_VALID = 2;
+const int SHOT_HIT = 4;
+const int SHOT_DESTROYED = 8;
+const uint32_t NO_CELL = 0xFFFFFFF;
+const uint32_t NO_CELL_NARROW = 0xFFF;
+const int MAX_NARROW_CELLS = 0xFFF;
+
+  // Bytes in each placement and shot of a record for a board this size
+inline int logCellBytes(int rows, int cols)
+{
+    return (long long)(rows) * cols < MAX_NARROW_CELLS ? 2 : 4;
+}
+
+  // Records every game it observes, appending each to the log file when the
+  // game ends.  Writes go through a large stdio buffer, so logging costs a
+  // few bytes of memcpy per shot.  Games whose fleets couldn't be placed
+  // aren't recorded.
+class GameLogWriter : public GameObserver
+{
+  public:
+    GameLogWriter(const std::string& path);
+    ~GameLogWriter();
+    bool isOpen() const { return m_file != nullptr; }
+    long long gamesWritten() const { return m_games; }
+
+    virtual void gameStarted(const Game& g, const Player* p1, const Board& b1,
+                             const Player* p2, const Board& b2);
+    virtual void turnStarted(const Player*, const Player*, const Board&) {}
+    virtual void attackMade(const Player* attacker, const Board& defenderBoard,
+                            Point p, bool validShot, bool shotHit,
+                            bool shipDestroyed, int shipId);
+    virtual void gameOver(const Player* winner, const Player* loser,
+                          const Board& winnerBoard);
+
+    GameLogWriter(const GameLogWriter&) = delete;
+    GameLogWriter& operator=(const GameLogWriter&) = delete;
+
+  private:
+    FILE* m_file;
+    std::vector<char> m_buffer;         // stdio's buffer for m_file
+    std::vector<unsigned char> m_record;
+    const Player* m_player1;
+    int m_rows;
+    int m_cols;
+    int m_cellBytes;
+    size_t m_winnerAt;                  // offsets into m_record
+    size_t m_nShotsAt;
+    uint32_t m_nShots;
+    long long m_games;
+
+    void put(uint32_t value, int nBytes);
+    void patch(size_t at, uint32_t value, int nBytes);
+};
+
+  // One record of a mapped log; it points into the mapping, so it is only
+  // good while the GameLogReader it came from is open.
+class GameRecord
+{
+  public:
+    GameRecord() : m_start(nullptr), m_nShips(0), m_cellBytes(4) {}
+    int rows() const { return get(4, 2); }
+    int cols() const { return get(6, 2); }
+    int nShips() const { return m_nShips; }
+    int shipLength(int shipId) const { return get(10 + 3 * shipId, 2); }
+    char shipSymbol(int shipId) const { return char(get(12 + 3 * shipId, 1)); }
+    int winner() const { return get(winnerAt(), 1); }
+      // Where player (1 or 2) put ship shipId
+    void placement(int player, int shipId, Point& topOrLeft, Direction& dir) const;
+    int nShots() const { return get(shotsAt() - 4, 4); }
+      // Shot k (from 0); false if it was off the board, so has no point.
+    bool shot(int k, Point& p, int& flags) const;
+
+  private:
+    friend class GameLogReader;
+    const unsigned char* m_start;
+    int m_nShips;
+    int m_cellBytes;
+
+    int winnerAt() const { return 10 + 3 * m_nShips; }
+    int shotsAt() const { return winnerAt() + 1 + 2 * m_nShips * m_cellBytes + 4; }
+    uint32_t get(size_t at, int nBytes) const
+    {
+        uint32_t value = 0;
+        for ( int i = nBytes - 1; i >= 0; i--)
+            value = (value << 8) | m_start[at + i];
+        return value;
+    }
+};
+
+  // Maps a log file into memory and walks its records in place.
+class GameLogReader
+{
+  public:
+    GameLogReader();
+    ~GameLogReader();
+      // Map path; false (with a message) if it isn't a readable game log.
+    bool open(const std::string& path);
+    void close();
+      // Set record to the next record; false at the end of the log, or if
+      // the rest of the file is truncated or damaged.
+    bool next(GameRecord& record);
+
+    GameLogReader(const GameLogReader&) = delete;
+    GameLogReader& operator=(const GameLogReader&) = delete;
+
+  private:
+    const unsigned char* m_data;
+    size_t m_size;
+    size_t m_pos;
+};
+
+  // Print win rates and shot counts for the games in the logs; false if
+  // some log couldn't be read.
+bool reportGameLogs(const std::vector<std::string>& paths);
+
+#endif // GAMELOG_INCLUDED
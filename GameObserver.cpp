@@ -0,0 +1,165 @@
+#include "GameObserver.h"
+#include "Board.h"
+#include "Game.h"
+#include "Player.h"
+#include "globals.h"
+#include <iostream>
+
+using namespace std;
+
+//******************** ConsoleGameObserver ****************************
+
+void ConsoleGameObserver::turnStarted(const Player* attacker, const Player* defender,
+                                      const Board& defenderBoard)
+{
+    cout << attacker->name() << "'s turn. Board for " << defender->name() << ":" << endl;
+    defenderBoard.display( attacker->isHuman() );
+}
+
+void ConsoleGameObserver::attackMade(const Player* attacker, const Board& defenderBoard,
+                                     Point p, bool validShot, bool shotHit,
+                                     bool shipDestroyed, int shipId)
+{
+    if ( !validShot )
+    {
+        cout << attacker->name() << " wasted a shot at (" << p.r << "," << p.c << ")." << endl;
+        return;
+    }
+
+    cout << attacker->name() << " attacked (" << p.r << "," << p.c << ") and ";
+    if ( shotHit && !shipDestroyed )
+        cout << "hit something";
+    else if ( shotHit && shipDestroyed )
+        cout << "destroyed the " << attacker->game().shipName(shipId);
+    else
+        cout << "missed";
+
+    cout <<", resulting in:" << endl;
+    defenderBoard.display( attacker->isHuman() );
+}
+
+void ConsoleGameObserver::gameOver(const Player* winner, const Player* loser,
+                                   const Board& winnerBoard)
+{
+    cout << winner->name() << " wins!" << endl;
+    if ( loser->isHuman() )
+    {
+        cout << "Here's where " << winner->name() << "'s ships were:" << endl;
+        winnerBoard.display(false);
+    }
+}
+
+//******************** TeeGameObserver ********************************
+
+void TeeGameObserver::gameStarted(const Game& g, const Player* p1, const Board& b1,
+                                  const Player* p2, const Board& b2)
+{
+    m_first.gameStarted(g, p1, b1, p2, b2);
+    m_second.gameStarted(g, p1, b1, p2, b2);
+}
+
+bool TeeGameObserver::timesCalls() const
+{
+    return m_first.timesCalls() || m_second.timesCalls();
+}
+
+void TeeGameObserver::callTimed(const Player* player, PlayerCall call, long long ns)
+{
+    if ( m_first.timesCalls() )
+        m_first.callTimed(player, call, ns);
+    if ( m_second.timesCalls() )
+        m_second.callTimed(player, call, ns);
+}
+
+void TeeGameObserver::turnStarted(const Player* attacker, const Player* defender,
+                                  const Board& defenderBoard)
+{
+    m_first.turnStarted(attacker, defender, defenderBoard);
+    m_second.turnStarted(attacker, defender, defenderBoard);
+}
+
+void TeeGameObserver::attackMade(const Player* attacker, const Board& defenderBoard,
+                                 Point p, bool validShot, bool shotHit,
+                                 bool shipDestroyed, int shipId)
+{
+    m_first.attackMade(attacker, defenderBoard, p, validShot, shotHit, shipDestroyed, shipId);
+    m_second.attackMade(attacker, defenderBoard, p, validShot, shotHit, shipDestroyed, shipId);
+}
+
+void TeeGameObserver::gameOver(const Player* winner, const Player* loser,
+                               const Board& winnerBoard)
+{
+    m_first.gameOver(winner, loser, winnerBoard);
+    m_second.gameOver(winner, loser, winnerBoard);
+}
+
+//******************** CountingGameObserver ***************************
+
+CountingGameObserver::CountingGameObserver()
+ : games(0), turns(0), wastedShots(0), hits(0), misses(0), shipsDestroyed(0)
+{}
+
+void CountingGameObserver::turnStarted(const Player*, const Player*, const Board&)
+{
+    turns++;
+}
+
+void CountingGameObserver::attackMade(const Player*, const Board&, Point,
+                                      bool validShot, bool shotHit,
+                                      bool shipDestroyed, int)
+{
+    if ( !validShot )
+        wastedShots++;
+    else if ( shotHit )
+        hits++;
+    else
+        misses++;
+    if ( shipDestroyed )
+        shipsDestroyed++;
+}
+
+void CountingGameObserver::gameOver(const Player*, const Player*, const Board&)
+{
+    games++;
+}
+
+void CountingGameObserver::add(const CountingGameObserver& other)
+{
+    games += other.games;
+    turns += other.turns;
+    wastedShots += other.wastedShots;
+    hits += other.hits;
+    misses += other.misses;
+    shipsDestroyed += other.shipsDestroyed;
+}
+
+//******************** LatencyGameObserver ****************************
+
+LatencyGameObserver::LatencyGameObserver()
+{
+    m_players[0] = nullptr;
+    m_players[1] = nullptr;
+}
+
+void LatencyGameObserver::setPlayers(const Player* player1, const Player* player2)
+{
+    m_players[0] = player1;
+    m_players[1] = player2;
+}
+
+void LatencyGameObserver::callTimed(const Player* player, PlayerCall call, long long ns)
+{
+    if ( player == m_players[0] )
+        m_histograms[0][call].record(ns);
+    else if ( player == m_players[1] )
+        m_histograms[1][call].record(ns);
+}
+
+void LatencyGameObserver::add(const LatencyGameObserver& other)
+{
+    for ( int p = 0; p < 2; p++)
+    {
+        for ( int c = 0; c < N_PLAYER_CALLS; c++)
+            m_histograms[p][c].add(other.m_histograms[p][c]);
+    }
+}
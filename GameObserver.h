@@ -0,0 +1,128 @@
+#ifndef GAMEOBSERVER_INCLUDED
+#define GAMEOBSERVER_INCLUDED
+
+#include "globals.h"
+#include "LatencyHistogram.h"
+
+class Board;
+class Game;
+class Player;
+
+  // The player calls Game::play can time
+enum PlayerCall { PLACE_SHIPS, RECOMMEND_ATTACK, RECORD_ATTACK_RESULT, N_PLAYER_CALLS };
+
+  // Everything Game::play reports about a game goes through an observer.
+  // ConsoleGameObserver prints what the interactive game always printed;
+  // the others let batch play skip all formatting and output.
+class GameObserver
+{
+  public:
+    virtual ~GameObserver() {}
+      // Called once both fleets are placed; most observers don't care.
+    virtual void gameStarted(const Game& g, const Player* p1, const Board& b1,
+                             const Player* p2, const Board& b2) {}
+      // Observers whose timesCalls returns true are told how long each
+      // player call took; for the others the clock is never read.
+    virtual bool timesCalls() const { return false; }
+    virtual void callTimed(const Player* player, PlayerCall call, long long ns) {}
+    virtual void turnStarted(const Player* attacker, const Player* defender,
+                             const Board& defenderBoard) = 0;
+    virtual void attackMade(const Player* attacker, const Board& defenderBoard,
+                            Point p, bool validShot, bool shotHit,
+                            bool shipDestroyed, int shipId) = 0;
+    virtual void gameOver(const Player* winner, const Player* loser,
+                          const Board& winnerBoard) = 0;
+};
+
+class ConsoleGameObserver : public GameObserver
+{
+  public:
+    virtual void turnStarted(const Player* attacker, const Player* defender,
+                             const Board& defenderBoard);
+    virtual void attackMade(const Player* attacker, const Board& defenderBoard,
+                            Point p, bool validShot, bool shotHit,
+                            bool shipDestroyed, int shipId);
+    virtual void gameOver(const Player* winner, const Player* loser,
+                          const Board& winnerBoard);
+};
+
+class NullGameObserver : public GameObserver
+{
+  public:
+    virtual void turnStarted(const Player*, const Player*, const Board&) {}
+    virtual void attackMade(const Player*, const Board&, Point, bool, bool,
+                            bool, int) {}
+    virtual void gameOver(const Player*, const Player*, const Board&) {}
+};
+
+  // Passes everything on to two other observers.
+class TeeGameObserver : public GameObserver
+{
+  public:
+    TeeGameObserver(GameObserver& first, GameObserver& second)
+     : m_first(first), m_second(second) {}
+    virtual void gameStarted(const Game& g, const Player* p1, const Board& b1,
+                             const Player* p2, const Board& b2);
+    virtual bool timesCalls() const;
+    virtual void callTimed(const Player* player, PlayerCall call, long long ns);
+    virtual void turnStarted(const Player* attacker, const Player* defender,
+                             const Board& defenderBoard);
+    virtual void attackMade(const Player* attacker, const Board& defenderBoard,
+                            Point p, bool validShot, bool shotHit,
+                            bool shipDestroyed, int shipId);
+    virtual void gameOver(const Player* winner, const Player* loser,
+                          const Board& winnerBoard);
+
+  private:
+    GameObserver& m_first;
+    GameObserver& m_second;
+};
+
+  // Tallies what happened over any number of games, without printing.
+class CountingGameObserver : public GameObserver
+{
+  public:
+    CountingGameObserver();
+    virtual void turnStarted(const Player* attacker, const Player* defender,
+                             const Board& defenderBoard);
+    virtual void attackMade(const Player* attacker, const Board& defenderBoard,
+                            Point p, bool validShot, bool shotHit,
+                            bool shipDestroyed, int shipId);
+    virtual void gameOver(const Player* winner, const Player* loser,
+                          const Board& winnerBoard);
+    void add(const CountingGameObserver& other);
+
+    long long games;
+    long long turns;
+    long long wastedShots;
+    long long hits;
+    long long misses;
+    long long shipsDestroyed;
+};
+
+  // Histograms of how long each call of each of two players took.  Give
+  // each thread its own and add() them up at the end.
+class LatencyGameObserver : public GameObserver
+{
+  public:
+    LatencyGameObserver();
+      // Calls by player1 are counted under 0, those by player2 under 1
+    void setPlayers(const Player* player1, const Player* player2);
+    virtual bool timesCalls() const { return true; }
+    virtual void callTimed(const Player* player, PlayerCall call, long long ns);
+    virtual void turnStarted(const Player*, const Player*, const Board&) {}
+    virtual void attackMade(const Player*, const Board&, Point, bool, bool,
+                            bool, int) {}
+    virtual void gameOver(const Player*, const Player*, const Board&) {}
+    void add(const LatencyGameObserver& other);
+    const LatencyHistogram& histogram(int player, PlayerCall call) const
+    {
+        return m_histograms[player][call];
+    }
+
+  private:
+    const Player* m_players[2];
+    LatencyHistogram m_histograms[2][N_PLAYER_CALLS];
+};
+
+#endif // GAMEOBSERVER_INCLUDED
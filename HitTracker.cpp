@@ -0,0 +1,173 @@
+#include "HitTracker.h"
+#include "Arena.h"
+#include "globals.h"
+#include <vector>
+using namespace std;
+
+HitTracker::HitTracker(int nRows, int nCols)
+ : m_rows(nRows), m_cols(nCols), m_hits(gameMemory()), m_label(nRows * nCols, -1, gameMemory()),
+   m_cluster(gameMemory()), m_pending(gameMemory())
+{}
+
+void HitTracker::reset()
+{
+    for ( int i = 0; i < m_hits.size(); i++)
+        m_label[m_hits[i]] = -1;
+    m_hits.clear();
+}
+
+void HitTracker::recordHit(int cell)
+{
+    if ( m_label[cell] != -1 )
+        return;
+    m_hits.push_back(cell);
+    m_label[cell] = 0;
+    relabel();
+}
+
+void HitTracker::recordSunk(const pmr::vector<char>& grid)
+{
+    int n = 0;
+    for ( int i = 0; i < m_hits.size(); i++)
+    {
+        if ( grid[m_hits[i]] == 'X' )
+            m_hits[n++] = m_hits[i];
+        else
+            m_label[m_hits[i]] = -1;
+    }
+    if ( n == m_hits.size() )
+        return;
+    m_hits.resize(n);
+    relabel();
+}
+
+  // Number the clusters of m_hits from 1, in order of their oldest hits
+void HitTracker::relabel()
+{
+    for ( int i = 0; i < m_hits.size(); i++)
+        m_label[m_hits[i]] = 0;
+    int next = 1;
+    for ( int i = 0; i < m_hits.size(); i++)
+    {
+        if ( m_label[m_hits[i]] != 0 )
+            continue;
+        m_label[m_hits[i]] = next;
+        m_pending.push_back(m_hits[i]);
+        while ( !m_pending.empty() )
+        {
+            int cell = m_pending.back();
+            m_pending.pop_back();
+            int r = cell / m_cols;
+            int c = cell % m_cols;
+            int neighbours[4] = { c > 0 ? cell - 1 : -1, c + 1 < m_cols ? cell + 1 : -1,
+                                  r > 0 ? cell - m_cols : -1, r + 1 < m_rows ? cell + m_cols : -1 };
+            for ( int k = 0; k < 4; k++)
+            {
+                if ( neighbours[k] != -1 && m_label[neighbours[k]] == 0 )
+                {
+                    m_label[neighbours[k]] = next;
+                    m_pending.push_back(neighbours[k]);
+                }
+            }
+        }
+        next++;
+    }
+}
+
+  // The placements of the ships afloat through both cell and hit, which
+  // are beside each other, on no 'o' or 'S' cell; each counts the 'X'
+  // cells it covers.
+long long HitTracker::scoreShot(const pmr::vector<char>& grid, const pmr::vector<int>& shipLengths,
+                                int cell, int hit) const
+{
+    bool across = (cell / m_cols == hit / m_cols);
+    int step = (across ? 1 : m_cols);
+    int pos = (across ? cell % m_cols : cell / m_cols);
+    int limit = (across ? m_cols : m_rows);
+    int lineStart = cell - pos * step;
+    int lo = (cell < hit ? pos : pos - 1);    // the pair's positions on the line
+    int hi = lo + 1;
+
+      // The open run around the pair
+    int first = lo;
+    while ( first > 0 && grid[lineStart + (first-1) * step] != 'o' && grid[lineStart + (first-1) * step] != 'S' )
+        first--;
+    int last = hi;
+    while ( last + 1 < limit && grid[lineStart + (last+1) * step] != 'o' && grid[lineStart + (last+1) * step] != 'S' )
+        last++;
+
+    long long score = 0;
+    for ( int s = 0; s < shipLengths.size(); s++)
+    {
+        int length = shipLengths[s];
+        int from = (hi - length + 1 > first ? hi - length + 1 : first);
+        int to = (lo + length - 1 < last ? lo : last - length + 1);
+        for ( int start = from; start <= to; start++)
+        {
+            for ( int i = start; i < start + length; i++)
+                score += (grid[lineStart + i * step] == 'X');
+        }
+    }
+    return score;
+}
+
+int HitTracker::bestCell(const pmr::vector<char>& grid, const pmr::vector<int>& shipLengths)
+{
+    int done = 0;    // clusters looked at so far (labels 1 to done)
+    for ( int i = 0; i < m_hits.size(); i++)
+    {
+        int label = m_label[m_hits[i]];
+        if ( label <= done )
+            continue;
+        done = label;
+
+        m_cluster.clear();
+        bool touchAcross = false;
+        bool touchDown = false;
+        for ( int k = i; k < m_hits.size(); k++)
+        {
+            int cell = m_hits[k];
+            if ( m_label[cell] != label )
+                continue;
+            m_cluster.push_back(cell);
+            if ( cell % m_cols + 1 < m_cols && m_label[cell + 1] == label )
+                touchAcross = true;
+            if ( cell / m_cols + 1 < m_rows && m_label[cell + m_cols] == label )
+                touchDown = true;
+        }
+
+          // Extend the cluster's runs if it lies one way; otherwise, or if
+          // no ship could, try every side of every hit.
+        bool lined = (touchAcross != touchDown);
+        for ( int pass = 0; pass < (lined ? 2 : 1); pass++)
+        {
+            bool tryAcross = !(pass == 0 && lined && !touchAcross);
+            bool tryDown = !(pass == 0 && lined && !touchDown);
+            long long bestScore = 0;
+            int best = -1;
+            for ( int k = 0; k < m_cluster.size(); k++)
+            {
+                int hit = m_cluster[k];
+                int r = hit / m_cols;
+                int c = hit % m_cols;
+                int sides[4] = { tryAcross && c > 0 ? hit - 1 : -1, tryAcross && c + 1 < m_cols ? hit + 1 : -1,
+                                 tryDown && r > 0 ? hit - m_cols : -1, tryDown && r + 1 < m_rows ? hit + m_cols : -1 };
+                for ( int d = 0; d < 4; d++)
+                {
+                    int cell = sides[d];
+                    if ( cell == -1 || grid[cell] != '.' )
+                        continue;
+                    long long score = scoreShot(grid, shipLengths, cell, hit);
+                    if ( score > bestScore || (score == bestScore && score > 0 && cell < best) )
+                    {
+                        bestScore = score;
+                        best = cell;
+                    }
+                }
+            }
+            if ( best != -1 )
+                return best;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,48 @@
+#ifndef HITTRACKER_INCLUDED
+#define HITTRACKER_INCLUDED
+
+#include "globals.h"
+#include <vector>
+#include <memory_resource>
+
+  // Follows up hits for GoodPlayer's heuristic policy, reading the same
+  // knowledge grid as DensityMap (see DensityMap.h).  The 'X' cells are kept
+  // in clusters of cells touching along a row or column, oldest first.  A
+  // cluster whose hits touch only across (or only down) is taken to be
+  // ships lying that way, and is extended at the ends of its runs; a single
+  // hit, or a cluster of ships lying side by side, tries every '.' cell
+  // beside its hits.  Each candidate scores the placements of the ships
+  // afloat that run through it and the hit beside it, each counting the
+  // hits it covers, so the shot goes where most of the cluster could
+  // continue, and never where no ship could.
+  //
+  // When a ship sinks, the hits markSunkShip pins on it (by its length)
+  // leave their cluster, which may split in two.  Hits it can't pin stay,
+  // and are shot around like any other until no ship could reach past them.
+class HitTracker
+{
+  public:
+    HitTracker(int nRows, int nCols);
+    void reset();
+      // A shot at cell hit
+    void recordHit(int cell);
+      // A ship sank, and markSunkShip has marked grid
+    void recordSunk(const std::pmr::vector<char>& grid);
+      // The '.' cell to shoot to follow up the oldest cluster that any ship
+      // afloat could still extend, or -1 if there is none
+    int bestCell(const std::pmr::vector<char>& grid, const std::pmr::vector<int>& shipLengths);
+
+  private:
+    int m_rows;
+    int m_cols;
+    std::pmr::vector<int> m_hits;      // 'X' cells, oldest first
+    std::pmr::vector<int> m_label;     // cluster of each cell in m_hits, by cell; -1 for others
+    std::pmr::vector<int> m_cluster;   // cells of the cluster being scored
+    std::pmr::vector<int> m_pending;   // cells waiting to be labelled
+
+    void relabel();
+    long long scoreShot(const std::pmr::vector<char>& grid, const std::pmr::vector<int>& shipLengths,
+                        int cell, int hit) const;
+};
+
+#endif // HITTRACKER_INCLUDED
@@ -0,0 +1,306 @@
+#include "Ladder.h"
+#include "Game.h"
+#include "Player.h"
+#include "FixedBoard.h"
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+using namespace std;
+
+  // Error rates of each pairing's SPRT: the chance of naming the weaker
+  // side stronger when the true difference is the margin.
+const double SPRT_ALPHA = 0.05;
+const double SPRT_BETA = 0.05;
+
+  // Virtual wins given each side of every pairing, so a pairing won 30-0
+  // still has a finite rating difference.
+const double PRIOR_WINS = 0.5;
+
+const double ELO_PER_NAT = 400 / log(10.0);
+
+bool parseTypeList(const string& text, vector<string>& types)
+{
+    types.clear();
+    size_t start = 0;
+    while ( start <= text.size() )
+    {
+        size_t end = text.find(',', start);
+        if ( end == string::npos )
+            end = text.size();
+        if ( end == start )
+            return false;
+        types.push_back(text.substr(start, end - start));
+        start = end + 1;
+    }
+    return types.size() >= 2;
+}
+
+bool parseLadderArgs(int argc, char* argv[], LadderSpec& spec)
+{
+    spec.types = computerPlayerTypes();
+    spec.batchGames = 32;
+    spec.maxGames = 2000;
+    spec.eloMargin = 20;
+    TournamentSpec& games = spec.games;
+    games.nGames = 0;
+    games.firstGame = 1;
+    games.nThreads = thread::hardware_concurrency();
+    if ( games.nThreads < 1 )
+        games.nThreads = 1;
+    games.rows = STANDARD_ROWS;
+    games.cols = STANDARD_COLS;
+    parseFleet("standard", games.fleet);
+    games.seed = random_device{}();
+    games.seed = (games.seed << 32) | random_device{}();
+    games.replayGame = 0;
+    games.timeCalls = false;
+    games.batchSlots = 0;
+
+    for ( int i = 2; i < argc; i += 2)
+    {
+        string option = argv[i];
+        if ( i + 1 >= argc )
+        {
+            cout << "Option " << option << " needs a value" << endl;
+            return false;
+        }
+        string value = argv[i+1];
+        if ( option == "--types" )
+        {
+            if ( !parseTypeList(value, spec.types) )
+            {
+                cout << "Bad type list " << value << "; expected at least two, like good,density" << endl;
+                return false;
+            }
+        }
+        else if ( option == "--batch" )
+            spec.batchGames = atoll(value.c_str());
+        else if ( option == "--max-games" )
+            spec.maxGames = atoll(value.c_str());
+        else if ( option == "--margin" )
+            spec.eloMargin = atof(value.c_str());
+        else if ( option == "--threads" )
+            games.nThreads = atoi(value.c_str());
+        else if ( option == "--rows" )
+            games.rows = atoi(value.c_str());
+        else if ( option == "--cols" )
+            games.cols = atoi(value.c_str());
+        else if ( option == "--seed" )
+            games.seed = strtoull(value.c_str(), nullptr, 10);
+        else if ( option == "--fleet" )
+        {
+            if ( !parseFleet(value, games.fleet) )
+            {
+                cout << "Bad fleet " << value << "; expected standard or a list like 5A,4B,3D" << endl;
+                return false;
+            }
+        }
+        else
+        {
+            cout << "Usage: " << argv[0] << " ladder [--types t1,t2,...] [--batch N] [--max-games N]"
+                 << " [--margin Elo] [--threads N] [--rows R] [--cols C] [--fleet ...] [--seed S]" << endl;
+            return false;
+        }
+    }
+    if ( spec.batchGames < 1 || spec.maxGames < 1 || games.nThreads < 1 || spec.eloMargin <= 0 )
+    {
+        cout << "The batch size, game limit, thread count and margin must be positive" << endl;
+        return false;
+    }
+      // Odd and even games swap who moves first, so keep batches even.
+    spec.batchGames += spec.batchGames % 2;
+
+    Game g(games.rows, games.cols);
+    if ( !addFleet(g, games.fleet) )
+        return false;
+    for ( int i = 0; i < spec.types.size(); i++)
+    {
+        Player* p = createPlayer(spec.types[i], spec.types[i], g);
+        if ( p == nullptr || p->isHuman() )
+        {
+            cout << "Player type " << spec.types[i] << " can't be used in a ladder" << endl;
+            delete p;
+            return false;
+        }
+        delete p;
+    }
+    return true;
+}
+
+  // Play one pairing until its SPRT decides or it reaches maxGames.
+LadderPairing playPairing(const LadderSpec& spec, int a, int b)
+{
+    LadderPairing pairing = { a, b, 0, 0, 0, 0.0, 0 };
+    double pStronger = 1 / (1 + pow(10.0, -spec.eloMargin / 400));
+    double llrPerWin = log(pStronger / (1 - pStronger));
+    double lower = log(SPRT_BETA / (1 - SPRT_ALPHA));
+    double upper = log((1 - SPRT_BETA) / SPRT_ALPHA);
+
+    TournamentSpec games = spec.games;
+    games.type1 = spec.types[a];
+    games.type2 = spec.types[b];
+    games.firstGame = 1;
+    games.nGames = spec.maxGames;
+      // One run, checked after every batch, so the players (and whatever
+      // a learning one has learned) last the whole pairing
+    TournamentResult result = runTournament(games, spec.batchGames, [&](const TournamentResult& soFar) {
+        pairing.llr = (soFar.wins1 - soFar.wins2) * llrPerWin;
+        if ( pairing.llr >= upper )
+            pairing.decision = 1;
+        else if ( pairing.llr <= lower )
+            pairing.decision = -1;
+        return pairing.decision == 0;
+    });
+    pairing.winsA = result.wins1;
+    pairing.winsB = result.wins2;
+    pairing.noResult = result.noResult;
+    return pairing;
+}
+
+  // Bradley-Terry strengths by Hunter's MM iteration, then their standard
+  // errors from the inverse of the Fisher information, with the first type
+  // held fixed at 0.
+void fitRatings(int n, const vector<LadderPairing>& pairings,
+                vector<double>& ratings, vector<double>& errors)
+{
+    vector< vector<double> > wins(n, vector<double>(n, 0));
+    for ( int k = 0; k < pairings.size(); k++)
+    {
+        const LadderPairing& p = pairings[k];
+        wins[p.a][p.b] += p.winsA + PRIOR_WINS;
+        wins[p.b][p.a] += p.winsB + PRIOR_WINS;
+    }
+
+    vector<double> gamma(n, 1);
+    for ( int iteration = 0; iteration < 10000; iteration++)
+    {
+        double change = 0;
+        for ( int i = 0; i < n; i++)
+        {
+            double won = 0;
+            double denominator = 0;
+            for ( int j = 0; j < n; j++)
+            {
+                if ( j == i || wins[i][j] + wins[j][i] == 0 )
+                    continue;
+                won += wins[i][j];
+                denominator += (wins[i][j] + wins[j][i]) / (gamma[i] + gamma[j]);
+            }
+            double updated = (denominator > 0 ? won / denominator : gamma[i]);
+            change = max(change, fabs(log(updated / gamma[i])));
+            gamma[i] = updated;
+        }
+        for ( int i = n - 1; i >= 0; i--)
+            gamma[i] /= gamma[0];
+        if ( change < 1e-10 )
+            break;
+    }
+    ratings.assign(n, 0);
+    for ( int i = 0; i < n; i++)
+        ratings[i] = ELO_PER_NAT * log(gamma[i]);
+
+      // Information matrix for types 1..n-1, inverted by Gauss-Jordan
+    int m = n - 1;
+    vector< vector<double> > info(m, vector<double>(2 * m, 0));
+    for ( int i = 1; i < n; i++)
+    {
+        for ( int j = 0; j < n; j++)
+        {
+            if ( j == i )
+                continue;
+            double games = wins[i][j] + wins[j][i];
+            double p = gamma[i] / (gamma[i] + gamma[j]);
+            double w = games * p * (1 - p);
+            info[i-1][i-1] += w;
+            if ( j > 0 )
+                info[i-1][j-1] -= w;
+        }
+        info[i-1][m + i - 1] = 1;
+    }
+    for ( int col = 0; col < m; col++)
+    {
+        int pivot = col;
+        for ( int r = col + 1; r < m; r++)
+        {
+            if ( fabs(info[r][col]) > fabs(info[pivot][col]) )
+                pivot = r;
+        }
+        swap(info[col], info[pivot]);
+        double d = info[col][col];
+        for ( int c = 0; c < 2 * m; c++)
+            info[col][c] /= d;
+        for ( int r = 0; r < m; r++)
+        {
+            if ( r == col || info[r][col] == 0 )
+                continue;
+            double f = info[r][col];
+            for ( int c = 0; c < 2 * m; c++)
+                info[r][c] -= f * info[col][c];
+        }
+    }
+    errors.assign(n, 0);
+    for ( int i = 1; i < n; i++)
+        errors[i] = 1.96 * ELO_PER_NAT * sqrt(info[i-1][m + i - 1]);
+}
+
+LadderResult runLadder(const LadderSpec& spec)
+{
+    LadderResult result;
+    result.games = 0;
+    result.seconds = 0;
+    int n = spec.types.size();
+    for ( int a = 0; a < n; a++)
+    {
+        for ( int b = a + 1; b < n; b++)
+        {
+            auto start = chrono::steady_clock::now();
+            LadderPairing pairing = playPairing(spec, a, b);
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            long long games = pairing.winsA + pairing.winsB + pairing.noResult;
+            result.games += games;
+            result.seconds += seconds;
+            result.pairings.push_back(pairing);
+
+            cout << "  " << spec.types[a] << " vs " << spec.types[b] << ": "
+                 << pairing.winsA << "-" << pairing.winsB << " in " << games << " games, ";
+            if ( pairing.decision == 0 )
+                cout << "undecided";
+            else
+                cout << spec.types[pairing.decision > 0 ? a : b] << " stronger";
+            cout << " (LLR " << fixed << setprecision(2) << pairing.llr
+                 << ", " << setprecision(1) << seconds << " s)" << defaultfloat << setprecision(6) << endl;
+        }
+    }
+    fitRatings(n, result.pairings, result.ratings, result.errors);
+    return result;
+}
+
+void reportLadder(const LadderSpec& spec, const LadderResult& result)
+{
+    int n = spec.types.size();
+    vector<int> order(n);
+    for ( int i = 0; i < n; i++)
+        order[i] = i;
+    sort(order.begin(), order.end(),
+         [&result](int x, int y) { return result.ratings[x] > result.ratings[y]; });
+
+    cout << "Ratings (Elo, " << spec.types[0] << " = 0, 95% intervals), "
+         << result.games << " games in " << result.seconds << " s, seed "
+         << spec.games.seed << ":" << endl;
+    for ( int k = 0; k < n; k++)
+    {
+        int i = order[k];
+        cout << "  " << setw(16) << left << spec.types[i] << right << fixed << setprecision(0)
+             << setw(6) << result.ratings[i];
+        if ( i != 0 )
+            cout << " +/- " << result.errors[i];
+        cout << defaultfloat << setprecision(6) << endl;
+    }
+}
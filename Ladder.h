@@ -0,0 +1,56 @@
+#ifndef LADDER_INCLUDED
+#define LADDER_INCLUDED
+
+#include "Tournament.h"
+#include <string>
+#include <vector>
+
+struct LadderSpec
+{
+    std::vector<std::string> types;     // every pair of these plays
+    TournamentSpec games;               // board, fleet, threads and seed for every pairing
+    long long batchGames;               // games a pairing plays between SPRT checks
+    long long maxGames;                 // most games a pairing plays
+    double eloMargin;                   // the SPRT decides between -margin and +margin
+};
+
+struct LadderPairing
+{
+    int a;                              // indexes into LadderSpec::types
+    int b;
+    long long winsA;
+    long long winsB;
+    long long noResult;
+    double llr;                         // log likelihood ratio of "a is stronger"
+    int decision;                       // 1 if a is stronger, -1 if b is, 0 if undecided
+};
+
+struct LadderResult
+{
+    std::vector<LadderPairing> pairings;
+    std::vector<double> ratings;        // Elo, by type; the first type is 0
+    std::vector<double> errors;         // half-width of each rating's 95% interval
+    long long games;
+    double seconds;
+};
+
+  // Fill spec from "ladder [--types t1,t2,...] [--batch N] [--max-games N]
+  // [--margin Elo] [--threads N] [--rows R] [--cols C] [--fleet ...]
+  // [--seed S]".  The types default to every computer player type.  Prints
+  // a message and returns false on bad input.
+bool parseLadderArgs(int argc, char* argv[], LadderSpec& spec);
+
+  // Play every pair of types against each other in batches of tournament
+  // games, stopping a pairing once a sequential probability ratio test
+  // (5% error each way) decides that one side is at least eloMargin
+  // stronger, or after maxGames.  Each pairing is one tournament run,
+  // checked after every batch, so a player that learns across games
+  // carries what it has learned through the whole pairing, as it would in
+  // a tournament.  Game k of a pairing is game k of a tournament between
+  // the two types with the spec's seed, so it can be replayed.  Then fit
+  // Bradley-Terry (Elo) ratings to all the results.
+  // Prints a line as each pairing finishes.
+LadderResult runLadder(const LadderSpec& spec);
+void reportLadder(const LadderSpec& spec, const LadderResult& result);
+
+#endif // LADDER_INCLUDED
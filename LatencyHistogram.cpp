@@ -0,0 +1,65 @@
+#include "LatencyHistogram.h"
+#include <cmath>
+using namespace std;
+
+LatencyHistogram::LatencyHistogram()
+ : m_count(0), m_max(0)
+{
+    for ( int i = 0; i < N_BUCKETS; i++)
+        m_counts[i] = 0;
+}
+
+  // Values below SUB_BUCKETS get a bucket each; above that, a value whose
+  // top bit is e lands in row e-SUB_BITS+1, column given by the SUB_BITS
+  // bits below its top bit.
+int LatencyHistogram::bucketOf(uint64_t ns)
+{
+    if ( ns < SUB_BUCKETS )
+        return int(ns);
+    int e = 63 - __builtin_clzll(ns);
+    int shift = e - SUB_BITS;
+    return (shift + 1) * SUB_BUCKETS + int((ns >> shift) - SUB_BUCKETS);
+}
+
+uint64_t LatencyHistogram::highestIn(int bucket)
+{
+    if ( bucket < SUB_BUCKETS )
+        return bucket;
+    int shift = bucket / SUB_BUCKETS - 1;
+    uint64_t lowest = uint64_t(bucket % SUB_BUCKETS + SUB_BUCKETS) << shift;
+    return lowest + ((uint64_t(1) << shift) - 1);
+}
+
+void LatencyHistogram::record(uint64_t ns)
+{
+    m_counts[bucketOf(ns)]++;
+    m_count++;
+    if ( ns > m_max )
+        m_max = ns;
+}
+
+void LatencyHistogram::add(const LatencyHistogram& other)
+{
+    for ( int i = 0; i < N_BUCKETS; i++)
+        m_counts[i] += other.m_counts[i];
+    m_count += other.m_count;
+    if ( other.m_max > m_max )
+        m_max = other.m_max;
+}
+
+uint64_t LatencyHistogram::percentile(double percent) const
+{
+    if ( m_count == 0 )
+        return 0;
+    long long rank = (long long)(ceil(percent / 100 * m_count));
+    if ( rank < 1 )
+        rank = 1;
+    long long seen = 0;
+    for ( int i = 0; i < N_BUCKETS; i++)
+    {
+        seen += m_counts[i];
+        if ( seen >= rank )
+            return highestIn(i) < m_max ? highestIn(i) : m_max;
+    }
+    return m_max;
+}
@@ -0,0 +1,36 @@
+#ifndef LATENCYHISTOGRAM_INCLUDED
+#define LATENCYHISTOGRAM_INCLUDED
+
+#include <cstdint>
+
+  // Counts durations in nanoseconds in log-linear buckets, in the manner of
+  // an HDR histogram: each power of two is split into 32 equal buckets, so
+  // any recorded value is known to within about 3%, from 1 ns up to the
+  // 64-bit limit, in a fixed 15 KB.  Recording is an index computation and
+  // an increment; histograms kept per thread are merged with add().
+class LatencyHistogram
+{
+  public:
+    LatencyHistogram();
+    void record(uint64_t ns);
+    void add(const LatencyHistogram& other);
+    long long count() const { return m_count; }
+    uint64_t max() const { return m_max; }
+      // The value below which percent% of the recorded values fall, to the
+      // histogram's precision; 0 if nothing was recorded.
+    uint64_t percentile(double percent) const;
+
+  private:
+    static const int SUB_BITS = 5;
+    static const int SUB_BUCKETS = 1 << SUB_BITS;
+    static const int N_BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+    long long m_counts[N_BUCKETS];
+    long long m_count;
+    uint64_t m_max;
+
+    static int bucketOf(uint64_t ns);
+    static uint64_t highestIn(int bucket);
+};
+
+#endif // LATENCYHISTOGRAM_INCLUDED
@@ -0,0 +1,147 @@
+#include "LayoutSearch.h"
+#include "ThreadPool.h"
+#include "Bitboard.h"
+#include "Arena.h"
+#include "globals.h"
+#include <vector>
+#include <random>
+#include <climits>
+using namespace std;
+
+class LayoutTask : public ArenaObject
+{
+  public:
+    LayoutTask(int nRows, int nCols);
+      // Get ready to draw layouts.  Called on the search's thread; it sizes
+      // everything drawLayout needs.
+    void start(const Bitboard& free, const pmr::vector<int>& lengths,
+               const pmr::vector<long long>& danger, unsigned seed);
+      // Draw one layout, and keep it if it is the safest so far
+    void drawLayout();
+    long long bestScore;          // LLONG_MAX until a layout is found
+    pmr::vector<ShipPlacement> best;
+
+  private:
+    int m_rows;
+    int m_cols;
+    const Bitboard* m_free;
+    const pmr::vector<int>* m_lengths;
+    const pmr::vector<long long>* m_danger;
+    mt19937 m_generator;
+    pmr::vector<char> m_used;     // cells taken by the layout being drawn
+    pmr::vector<int> m_placed;    // those cells, so m_used can be reset cheaply
+    pmr::vector<ShipPlacement> m_layout;
+
+    int random(int limit) { return uniform_int_distribution<>(0, limit-1)(m_generator); }
+    bool fits(int start, int step, int length) const;
+};
+
+LayoutTask::LayoutTask(int nRows, int nCols)
+ : bestScore(LLONG_MAX), best(gameMemory()), m_rows(nRows), m_cols(nCols),
+   m_free(nullptr), m_lengths(nullptr), m_danger(nullptr),
+   m_used(nRows * nCols, gameMemory()), m_placed(gameMemory()), m_layout(gameMemory())
+{}
+
+void LayoutTask::start(const Bitboard& free, const pmr::vector<int>& lengths,
+                       const pmr::vector<long long>& danger, unsigned seed)
+{
+    m_free = &free;
+    m_lengths = &lengths;
+    m_danger = &danger;
+    m_generator.seed(seed);
+    bestScore = LLONG_MAX;
+    int totalLength = 0;
+    for ( int i = 0; i < lengths.size(); i++)
+        totalLength += lengths[i];
+    m_placed.reserve(totalLength);
+    m_layout.resize(lengths.size());
+    best.resize(lengths.size());
+}
+
+bool LayoutTask::fits(int start, int step, int length) const
+{
+    for ( int i = 0, cell = start; i < length; i++, cell += step)
+    {
+        if ( m_used[cell] || !m_free->test(cell) )
+            return false;
+    }
+    return true;
+}
+
+void LayoutTask::drawLayout()
+{
+    for ( int i = 0; i < m_placed.size(); i++)
+        m_used[m_placed[i]] = 0;
+    m_placed.clear();
+
+    long long score = 0;
+    for ( int s = 0; s < m_lengths->size(); s++)
+    {
+        int length = (*m_lengths)[s];
+        bool dropped = false;
+        for ( int t = 0; t < DROP_TRIES && !dropped; t++)
+        {
+            Direction dir = (random(2) == 0 ? HORIZONTAL : VERTICAL);
+            if ( length > (dir == HORIZONTAL ? m_cols : m_rows) )
+                continue;
+            int r = random(dir == HORIZONTAL ? m_rows : m_rows - length + 1);
+            int c = random(dir == HORIZONTAL ? m_cols - length + 1 : m_cols);
+            int step = (dir == HORIZONTAL ? 1 : m_cols);
+            if ( !fits(r * m_cols + c, step, length) )
+                continue;
+            for ( int i = 0, cell = r * m_cols + c; i < length; i++, cell += step)
+            {
+                m_used[cell] = 1;
+                m_placed.push_back(cell);
+                score += (*m_danger)[cell];
+            }
+            m_layout[s] = ShipPlacement { Point(r, c), dir };
+            dropped = true;
+        }
+          // Give up on a layout that can't be placed or can't win
+        if ( !dropped || score >= bestScore )
+            return;
+    }
+    bestScore = score;
+    best = m_layout;
+}
+
+LayoutSearch::LayoutSearch(int nRows, int nCols)
+ : m_rows(nRows), m_cols(nCols), m_tasks(gameMemory())
+{
+      // Made now rather than on first use, so they come from the same
+      // memory as the search even if it outlives the scope it was made in.
+    for ( int t = 0; t < ThreadPool::BUDGET_TASKS; t++)
+        m_tasks.push_back(new LayoutTask(m_rows, m_cols));
+}
+
+LayoutSearch::~LayoutSearch()
+{
+    for ( int t = 0; t < m_tasks.size(); t++)
+        delete m_tasks[t];
+}
+
+bool LayoutSearch::search(const Bitboard& free, const pmr::vector<int>& lengths,
+                          const pmr::vector<long long>& danger, int nLayouts, int budgetMs,
+                          ThreadPool& pool, pmr::vector<ShipPlacement>& placements)
+{
+    for ( int t = 0; t < m_tasks.size(); t++)
+        m_tasks[t]->start(free, lengths, danger, randomGenerator()());
+
+    pool.parallelForBudget(m_tasks.size(), nLayouts, budgetMs, [this](int t) {
+        m_tasks[t]->drawLayout();
+    });
+
+      // The safest layout; the lowest-numbered task's on a tie
+    int bestTask = -1;
+    for ( int t = 0; t < m_tasks.size(); t++)
+    {
+        if ( m_tasks[t]->bestScore != LLONG_MAX &&
+             (bestTask == -1 || m_tasks[t]->bestScore < m_tasks[bestTask]->bestScore) )
+            bestTask = t;
+    }
+    if ( bestTask == -1 )
+        return false;
+    placements.assign(m_tasks[bestTask]->best.begin(), m_tasks[bestTask]->best.end());
+    return true;
+}
@@ -0,0 +1,47 @@
+#ifndef LAYOUTSEARCH_INCLUDED
+#define LAYOUTSEARCH_INCLUDED
+
+#include "PlacementSolver.h"
+#include <vector>
+#include <memory_resource>
+
+class Bitboard;
+class ThreadPool;
+class LayoutTask;
+
+  // Chooses where to put a fleet so that an opponent's usual shots find it
+  // late.  danger[cell] says how early, and how often, the opponent tends
+  // to shoot at cell; a layout's score is the total danger of its cells, and
+  // the search draws random layouts on the free cells and keeps the one
+  // with the lowest score.
+  //
+  // As with PlacementSampler, draws are split into a fixed number of tasks
+  // run on a ThreadPool, each with its own generator seeded from randInt,
+  // so with a layout count the choice depends only on the caller's random
+  // sequence, and with a time budget on how far the tasks got.  The tasks
+  // are made when the search is, and sized on the calling thread.
+class LayoutSearch
+{
+  public:
+    LayoutSearch(int nRows, int nCols);
+    ~LayoutSearch();
+
+      // Draw nLayouts layouts of ships of the given lengths on cells set in
+      // free, or as many as fit in budgetMs when budgetMs is positive, and
+      // set placements[i] to where ship i goes in the safest.  Returns false
+      // if no layout was found.
+    bool search(const Bitboard& free, const std::pmr::vector<int>& lengths,
+                const std::pmr::vector<long long>& danger, int nLayouts, int budgetMs,
+                ThreadPool& pool, std::pmr::vector<ShipPlacement>& placements);
+
+  private:
+    int m_rows;
+    int m_cols;
+    std::pmr::vector<LayoutTask*> m_tasks;
+
+      // We prevent a LayoutSearch object from being copied or assigned
+    LayoutSearch(const LayoutSearch&) = delete;
+    LayoutSearch& operator=(const LayoutSearch&) = delete;
+};
+
+#endif // LAYOUTSEARCH_INCLUDED
@@ -0,0 +1,24 @@
+#include "Match.h"
+#include "Game.h"
+#include "Player.h"
+#include "GameObserver.h"
+using namespace std;
+
+Match::Match(Game& g, Player* p1, Player* p2)
+ : m_game(g), m_p1(p1), m_p2(p2), m_board1(g), m_board2(g), m_gamesPlayed(0)
+{}
+
+Player* Match::play(bool p1First, GameObserver& observer, bool shouldPause)
+{
+    if ( m_gamesPlayed > 0 )
+    {
+        m_board1.clear();
+        m_board2.clear();
+        m_p1->reset();
+        m_p2->reset();
+    }
+    m_gamesPlayed++;
+    if ( p1First )
+        return m_game.play(m_p1, m_p2, m_board1, m_board2, observer, shouldPause);
+    return m_game.play(m_p2, m_p1, m_board2, m_board1, observer, shouldPause);
+}
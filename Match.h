@@ -0,0 +1,38 @@
+#ifndef MATCH_INCLUDED
+#define MATCH_INCLUDED
+
+#include "Board.h"
+
+class Game;
+class Player;
+class GameObserver;
+
+  // A series of games between the same two players on the same Game.  The
+  // boards and players are kept from one game to the next: before each
+  // game the boards are cleared and the players reset, so setting up a
+  // game costs the same however many the match has played.
+class Match
+{
+  public:
+      // g must already have its fleet.  The match uses g and the players
+      // but doesn't own them.
+    Match(Game& g, Player* p1, Player* p2);
+      // Play one game, p1 moving first if p1First; returns the winner, or
+      // nullptr if a fleet couldn't be placed.
+    Player* play(bool p1First, GameObserver& observer, bool shouldPause = false);
+    int gamesPlayed() const { return m_gamesPlayed; }
+
+      // We prevent a Match object from being copied or assigned
+    Match(const Match&) = delete;
+    Match& operator=(const Match&) = delete;
+
+  private:
+    Game& m_game;
+    Player* m_p1;
+    Player* m_p2;
+    Board m_board1;
+    Board m_board2;
+    int m_gamesPlayed;
+};
+
+#endif // MATCH_INCLUDED
@@ -0,0 +1,104 @@
+#include "PlacementKernels.h"
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS
+#endif
+using namespace std;
+
+void clearCoverage(CoverageCounts& counts)
+{
+    memset(counts.n, 0, sizeof(counts.n));
+}
+
+  // Each kernel adds weight to counts for every bit set in mask
+
+static void addMaskScalar(uint16_t* counts, CellMask mask, uint16_t weight)
+{
+    uint64_t words[2] = { uint64_t(mask), uint64_t(mask >> 64) };
+    for ( int w = 0; w < 2; w++)
+    {
+        for ( uint64_t bits = words[w]; bits != 0; bits &= bits - 1)
+            counts[64 * w + __builtin_ctzll(bits)] += weight;
+    }
+}
+
+#ifdef HAVE_X86_KERNELS
+
+  // Broadcast a chunk of the mask to every lane, keep each lane's own bit,
+  // and turn the lanes whose bit is set into weight.
+
+__attribute__((target("sse2")))
+static void addMaskSse2(uint16_t* counts, CellMask mask, uint16_t weight)
+{
+    const __m128i laneBits = _mm_setr_epi16(1, 2, 4, 8, 16, 32, 64, 128);
+    const __m128i w = _mm_set1_epi16(weight);
+    for ( int chunk = 0; chunk < 16; chunk++, mask >>= 8)
+    {
+        int bits = int(mask & 0xFF);
+        if ( bits == 0 )
+            continue;
+        __m128i set = _mm_cmpeq_epi16(_mm_and_si128(_mm_set1_epi16(bits), laneBits), laneBits);
+        __m128i* p = reinterpret_cast<__m128i*>(counts + 8 * chunk);
+        _mm_store_si128(p, _mm_add_epi16(_mm_load_si128(p), _mm_and_si128(set, w)));
+    }
+}
+
+__attribute__((target("avx2")))
+static void addMaskAvx2(uint16_t* counts, CellMask mask, uint16_t weight)
+{
+    const __m256i laneBits = _mm256_setr_epi16(1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024,
+                                               2048, 4096, 8192, 16384, short(32768));
+    const __m256i w = _mm256_set1_epi16(weight);
+    for ( int chunk = 0; chunk < 8; chunk++, mask >>= 16)
+    {
+        int bits = int(mask & 0xFFFF);
+        if ( bits == 0 )
+            continue;
+        __m256i set = _mm256_cmpeq_epi16(_mm256_and_si256(_mm256_set1_epi16(short(bits)), laneBits), laneBits);
+        __m256i* p = reinterpret_cast<__m256i*>(counts + 16 * chunk);
+        _mm256_store_si256(p, _mm256_add_epi16(_mm256_load_si256(p), _mm256_and_si256(set, w)));
+    }
+}
+
+#endif // HAVE_X86_KERNELS
+
+typedef void (*AddMask)(uint16_t* counts, CellMask mask, uint16_t weight);
+
+struct CoverageKernel
+{
+    AddMask addMask;
+    const char* name;
+};
+
+static CoverageKernel chooseKernel()
+{
+#ifdef HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if ( __builtin_cpu_supports("avx2") )
+        return CoverageKernel { addMaskAvx2, "avx2" };
+    if ( __builtin_cpu_supports("sse2") )
+        return CoverageKernel { addMaskSse2, "sse2" };
+#endif
+    return CoverageKernel { addMaskScalar, "scalar" };
+}
+
+static const CoverageKernel& kernel()
+{
+    static const CoverageKernel chosen = chooseKernel();
+    return chosen;
+}
+
+void addCoverage(CoverageCounts& counts, CellMask starts, int length, int step, uint16_t weight)
+{
+    if ( starts == 0 )
+        return;
+    AddMask addMask = kernel().addMask;
+    for ( int i = 0; i < length; i++)
+        addMask(counts.n, starts << (i * step), weight);
+}
+
+const char* coverageKernel()
+{
+    return kernel().name;
+}
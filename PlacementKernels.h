@@ -0,0 +1,54 @@
+#ifndef PLACEMENTKERNELS_INCLUDED
+#define PLACEMENTKERNELS_INCLUDED
+
+#include "FixedBoard.h"
+#include <cstdint>
+
+  // Placement counting on boards of at most 128 cells, as whole-board
+  // CellMask operations.  For one ship length and direction, every legal
+  // placement on a mask of usable cells is found at once (its top or left
+  // cell is set in placementStarts), and addCoverage then adds, for every
+  // cell, how many of them cover it.  addCoverage is the inner loop of any
+  // density count; it turns mask bits into per-cell counters with AVX2 or
+  // SSE2 where the CPU has them, and with a scalar loop otherwise.
+
+  // One counter per cell, row by row
+struct CoverageCounts
+{
+    alignas(32) uint16_t n[128];
+};
+
+void clearCoverage(CoverageCounts& counts);
+
+  // For each of the `length` cells of every placement whose start is set in
+  // starts (placements going `step` cells at a time), add weight to that
+  // cell's counter.  Counters wrap at 65536.
+void addCoverage(CoverageCounts& counts, CellMask starts, int length, int step, uint16_t weight);
+
+  // "avx2", "sse2" or "scalar": the addCoverage kernel this CPU uses
+const char* coverageKernel();
+
+  // The top or left cells of every placement of a ship of the given length
+  // that lies entirely on cells set in usable
+template<int Rows, int Cols>
+inline CellMask placementStarts(CellMask usable, int length, Direction dir)
+{
+    const int step = (dir == HORIZONTAL ? 1 : Cols);
+    CellMask starts = usable & shipMasks<Rows, Cols>.starts[dir][length];
+    for ( int i = 1; i < length && starts != 0; i++)
+        starts &= usable >> (i * step);
+    return starts;
+}
+
+  // The cells covered by at least one placement whose start is in starts
+template<int Rows, int Cols>
+inline CellMask coveredCells(CellMask starts, int length, Direction dir)
+{
+    const int step = (dir == HORIZONTAL ? 1 : Cols);
+    CellMask covered = 0;
+    for ( int i = 0; i < length; i++)
+        covered |= starts << (i * step);
+    return covered;
+}
+
+#endif // PLACEMENTKERNELS_INCLUDED
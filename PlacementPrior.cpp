@@ -0,0 +1,47 @@
+#include "PlacementPrior.h"
+#include "Arena.h"
+#include <vector>
+using namespace std;
+
+PlacementPrior::PlacementPrior(int nRows, int nCols, int fleetCells)
+ : m_mean(double(fleetCells) / (nRows * nCols)), m_games(0),
+   m_shipSeen(nRows * nCols, gameMemory()), m_looked(nRows * nCols, gameMemory()),
+   m_weight(nRows * nCols, gameMemory())
+{
+    clear();
+}
+
+void PlacementPrior::clear()
+{
+    m_games = 0;
+    for ( int i = 0; i < m_weight.size(); i++)
+    {
+        m_shipSeen[i] = 0;
+        m_looked[i] = 0;
+        m_weight[i] = WEIGHT_ONE;
+    }
+}
+
+void PlacementPrior::addGame(const pmr::vector<char>& grid)
+{
+    bool anyShots = false;
+    for ( int i = 0; i < grid.size() && !anyShots; i++)
+        anyShots = grid[i] != '.';
+    if ( !anyShots )
+        return;
+
+    m_games++;
+    for ( int i = 0; i < grid.size(); i++)
+    {
+        if ( grid[i] == '.' )
+            continue;
+        m_looked[i]++;
+        if ( grid[i] != 'o' )
+            m_shipSeen[i]++;
+          // (seen + PRIOR_GAMES * mean) / (looked + PRIOR_GAMES), over mean
+        double chance = (m_shipSeen[i] + PRIOR_GAMES * m_mean) / (m_looked[i] + PRIOR_GAMES);
+        m_weight[i] = int(WEIGHT_ONE * chance / m_mean + 0.5);
+        if ( m_weight[i] < 1 )
+            m_weight[i] = 1;
+    }
+}
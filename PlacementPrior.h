@@ -0,0 +1,39 @@
+#ifndef PLACEMENTPRIOR_INCLUDED
+#define PLACEMENTPRIOR_INCLUDED
+
+#include <vector>
+#include <memory_resource>
+
+  // Where one opponent has been seen to put its ships, over the games of a
+  // match.  At the end of each game the attacker's knowledge grid (see
+  // DensityMap.h) is folded in: its 'X' and 'S' cells held a ship and its
+  // 'o' cells didn't.  Each cell's chance of holding a ship is estimated
+  // with a Beta prior centred on the fleet's share of the board, so cells
+  // never looked at stay at the average and a few games can't drive a cell
+  // all the way to zero.  weight() gives that chance relative to the
+  // average, in units of WEIGHT_ONE, for scaling placement scores.
+class PlacementPrior
+{
+  public:
+    static const int WEIGHT_ONE = 256;
+
+    PlacementPrior(int nRows, int nCols, int fleetCells);
+    void clear();
+      // Add what grid shows of the game just finished; a grid with no
+      // shots in it adds nothing.
+    void addGame(const std::pmr::vector<char>& grid);
+    int games() const { return m_games; }
+    int weight(int cell) const { return m_weight[cell]; }
+
+  private:
+      // How many games' worth of the average the estimate starts from
+    static const int PRIOR_GAMES = 2;
+
+    double m_mean;                          // fleet cells / board cells
+    int m_games;
+    std::pmr::vector<int> m_shipSeen;       // games a ship was seen on each cell
+    std::pmr::vector<int> m_looked;         // games each cell was shot at
+    std::pmr::vector<int> m_weight;
+};
+
+#endif // PLACEMENTPRIOR_INCLUDED
@@ -0,0 +1,268 @@
+#include "PlacementSampler.h"
+#include "ThreadPool.h"
+#include "PlacementTable.h"
+#include "Arena.h"
+#include "globals.h"
+#include <vector>
+#include <random>
+#include <algorithm>
+using namespace std;
+
+class SamplingTask : public ArenaObject
+{
+  public:
+    SamplingTask(int nRows, int nCols);
+      // Get ready to draw fleets for this grid.  Called on the sampler's
+      // thread; it sizes everything drawFleet needs.
+    void start(const pmr::vector<char>& grid, const pmr::vector<int>& shipLengths,
+               const pmr::vector<int>& hits, unsigned seed);
+    bool drawFleet();
+    pmr::vector<int> counts;
+    int drawn;
+
+  private:
+    int m_rows;
+    int m_cols;
+    const pmr::vector<char>* m_grid;
+    const pmr::vector<int>* m_lengths;
+    const pmr::vector<int>* m_hits;
+    mt19937 m_generator;
+    pmr::vector<char> m_used;     // cells taken by the fleet being drawn
+    pmr::vector<int> m_placed;    // those cells, so m_used can be reset cheaply
+    pmr::vector<int> m_unplaced;  // indexes into m_lengths
+    pmr::vector<int> m_candidates; // (start, step) pairs through one hit
+    bool m_tabled;                // at most MAX_TABLE_CELLS cells, so coverHit can use tables
+    pmr::vector<const PlacementTable*> m_tables;   // by length, looked up when first needed
+
+    int random(int limit) { return uniform_int_distribution<>(0, limit-1)(m_generator); }
+    bool fits(int start, int step, int length) const;
+    void place(int start, int step, int length);
+    bool coverHit(int cell);
+    bool dropShip(int length);
+};
+
+SamplingTask::SamplingTask(int nRows, int nCols)
+ : counts(nRows * nCols, gameMemory()), drawn(0), m_rows(nRows), m_cols(nCols),
+   m_grid(nullptr), m_lengths(nullptr), m_hits(nullptr),
+   m_used(nRows * nCols, gameMemory()), m_placed(gameMemory()),
+   m_unplaced(gameMemory()), m_candidates(gameMemory()),
+   m_tabled(nRows * nCols <= MAX_TABLE_CELLS), m_tables(gameMemory())
+{}
+
+void SamplingTask::start(const pmr::vector<char>& grid, const pmr::vector<int>& shipLengths,
+                         const pmr::vector<int>& hits, unsigned seed)
+{
+    m_grid = &grid;
+    m_lengths = &shipLengths;
+    m_hits = &hits;
+    m_generator.seed(seed);
+    for ( int i = 0; i < counts.size(); i++)
+        counts[i] = 0;
+    drawn = 0;
+    int totalLength = 0;
+    int longest = 0;
+    for ( int i = 0; i < shipLengths.size(); i++)
+    {
+        totalLength += shipLengths[i];
+        if ( shipLengths[i] > longest )
+            longest = shipLengths[i];
+    }
+    m_placed.reserve(totalLength);
+    m_unplaced.reserve(shipLengths.size());
+    m_candidates.reserve(2 * longest);
+    if ( m_tabled )
+    {
+        if ( longest >= m_tables.size() )
+            m_tables.resize(longest + 1, nullptr);
+        for ( int i = 0; i < shipLengths.size(); i++)
+        {
+            if ( m_tables[shipLengths[i]] == nullptr )
+                m_tables[shipLengths[i]] = PlacementTable::forShip(m_rows, m_cols, shipLengths[i]);
+        }
+    }
+}
+
+bool SamplingTask::fits(int start, int step, int length) const
+{
+    for ( int i = 0, cell = start; i < length; i++, cell += step)
+    {
+        if ( m_used[cell] || (*m_grid)[cell] == 'o' || (*m_grid)[cell] == 'S' )
+            return false;
+    }
+    return true;
+}
+
+void SamplingTask::place(int start, int step, int length)
+{
+    for ( int i = 0, cell = start; i < length; i++, cell += step)
+    {
+        m_used[cell] = 1;
+        m_placed.push_back(cell);
+    }
+}
+
+bool SamplingTask::coverHit(int cell)
+{
+      // Try the unplaced ships in random order; use the first with any
+      // legal placement through cell, picking one of those at random.
+    for ( int n = m_unplaced.size(); n > 0; n--)
+    {
+        int pick = random(n);
+        swap(m_unplaced[pick], m_unplaced[n-1]);
+        int length = (*m_lengths)[m_unplaced[n-1]];
+
+        m_candidates.clear();
+        if ( m_tabled )
+        {
+            const PlacementTable& table = *m_tables[length];
+            for ( const int* p = table.coverBegin(cell); p != table.coverEnd(cell); p++)
+            {
+                int start = table.start(*p);
+                if ( table.dir(*p) == HORIZONTAL ? fits(start, 1, length) : fits(start, m_cols, length) )
+                    m_candidates.push_back(table.dir(*p) == HORIZONTAL ? start : -1 - start);
+            }
+        }
+        else
+        {
+            int row = cell / m_cols;
+            int col = cell % m_cols;
+            for ( int k = 0; k < length; k++)
+            {
+                if ( col - k >= 0 && col - k + length <= m_cols && fits(cell - k, 1, length) )
+                    m_candidates.push_back(cell - k);
+                if ( row - k >= 0 && row - k + length <= m_rows && fits(cell - k * m_cols, m_cols, length) )
+                    m_candidates.push_back(-1 - (cell - k * m_cols));    // vertical starts stored negated
+            }
+        }
+        if ( m_candidates.empty() )
+            continue;
+
+        int start = m_candidates[random(m_candidates.size())];
+        if ( start >= 0 )
+            place(start, 1, length);
+        else
+            place(-1 - start, m_cols, length);
+        m_unplaced.erase(m_unplaced.begin() + n - 1);
+        return true;
+    }
+    return false;
+}
+
+bool SamplingTask::dropShip(int length)
+{
+    for ( int t = 0; t < DROP_TRIES; t++)
+    {
+        if ( random(2) == 0 )
+        {
+            if ( length > m_cols )
+                continue;
+            int start = random(m_rows) * m_cols + random(m_cols - length + 1);
+            if ( fits(start, 1, length) )
+            {
+                place(start, 1, length);
+                return true;
+            }
+        }
+        else
+        {
+            if ( length > m_rows )
+                continue;
+            int start = random(m_rows - length + 1) * m_cols + random(m_cols);
+            if ( fits(start, m_cols, length) )
+            {
+                place(start, m_cols, length);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool SamplingTask::drawFleet()
+{
+    for ( int i = 0; i < m_placed.size(); i++)
+        m_used[m_placed[i]] = 0;
+    m_placed.clear();
+    m_unplaced.clear();
+    for ( int i = 0; i < m_lengths->size(); i++)
+        m_unplaced.push_back(i);
+
+    for ( int i = 0; i < m_hits->size(); i++)
+    {
+        if ( !m_used[(*m_hits)[i]] && !coverHit((*m_hits)[i]) )
+            return false;
+    }
+    for ( int i = 0; i < m_unplaced.size(); i++)
+    {
+        if ( !dropShip((*m_lengths)[m_unplaced[i]]) )
+            return false;
+    }
+
+    for ( int i = 0; i < m_placed.size(); i++)
+        counts[m_placed[i]]++;
+    return true;
+}
+
+PlacementSampler::PlacementSampler(int nRows, int nCols)
+ : m_rows(nRows), m_cols(nCols), m_counts(nRows * nCols, gameMemory()),
+   m_hits(gameMemory()), m_tasks(gameMemory())
+{
+      // Made now rather than on first use, so they come from the same
+      // memory as the sampler even if it outlives the scope it was made in.
+    for ( int t = 0; t < ThreadPool::BUDGET_TASKS; t++)
+        m_tasks.push_back(new SamplingTask(m_rows, m_cols));
+}
+
+PlacementSampler::~PlacementSampler()
+{
+    for ( int t = 0; t < m_tasks.size(); t++)
+        delete m_tasks[t];
+}
+
+int PlacementSampler::sample(const pmr::vector<char>& grid, const pmr::vector<int>& shipLengths,
+                             int nSamples, int budgetMs, ThreadPool& pool)
+{
+    m_hits.clear();
+    for ( int i = 0; i < grid.size(); i++)
+    {
+        if ( grid[i] == 'X' )
+            m_hits.push_back(i);
+    }
+    for ( int t = 0; t < m_tasks.size(); t++)
+        m_tasks[t]->start(grid, shipLengths, m_hits, randomGenerator()());
+
+    pool.parallelForBudget(m_tasks.size(), nSamples, budgetMs, [this](int t) {
+        if ( m_tasks[t]->drawFleet() )
+            m_tasks[t]->drawn++;
+    });
+
+    int total = 0;
+    for ( int i = 0; i < m_counts.size(); i++)
+        m_counts[i] = 0;
+    for ( int t = 0; t < m_tasks.size(); t++)
+    {
+        total += m_tasks[t]->drawn;
+        for ( int i = 0; i < m_counts.size(); i++)
+            m_counts[i] += m_tasks[t]->counts[i];
+    }
+    return total;
+}
+
+int PlacementSampler::bestCell(const pmr::vector<char>& grid) const
+{
+    int best = -1;
+    int ties = 0;
+    for ( int i = 0; i < m_counts.size(); i++)
+    {
+        if ( grid[i] != '.' )
+            continue;
+        if ( best == -1 || m_counts[i] > m_counts[best] )
+        {
+            best = i;
+            ties = 1;
+        }
+        else if ( m_counts[i] == m_counts[best] && randInt(++ties) == 0 )
+            best = i;
+    }
+    return best;
+}
@@ -0,0 +1,51 @@
+#ifndef PLACEMENTSAMPLER_INCLUDED
+#define PLACEMENTSAMPLER_INCLUDED
+
+#include <vector>
+#include <memory_resource>
+
+class ThreadPool;
+class SamplingTask;
+
+  // Estimates where the opponent's ships are by drawing random fleets that
+  // agree with an attacker's knowledge grid (see DensityMap.h): no ship on
+  // an 'o' or 'S' cell, every 'X' cell covered, one ship per remaining
+  // length.  Each draw first covers the hits one at a time with a ship
+  // through that hit, then drops the other ships anywhere still legal.
+  //
+  // Draws are split into a fixed number of tasks run on a ThreadPool.  Each
+  // task has its own generator seeded from randInt, so with a sample count
+  // the result depends only on the caller's random sequence; with a time
+  // budget, on how far the tasks got.  The tasks and their scratch space
+  // are kept from one call to the next and sized on the calling thread, so
+  // the pool's threads never allocate.
+class PlacementSampler
+{
+  public:
+    PlacementSampler(int nRows, int nCols);
+    ~PlacementSampler();
+
+      // Draw nSamples fleets, or as many as fit in budgetMs when budgetMs
+      // is positive, and count for every cell the fleets covering it.
+      // Returns the number of fleets drawn; 0 means no consistent fleet
+      // was found.
+    int sample(const std::pmr::vector<char>& grid, const std::pmr::vector<int>& shipLengths,
+               int nSamples, int budgetMs, ThreadPool& pool);
+    long long count(int cell) const { return m_counts[cell]; }
+      // Index of a '.' cell covered by the most fleets (ties broken at
+      // random), or -1 if no '.' cell is left.
+    int bestCell(const std::pmr::vector<char>& grid) const;
+
+  private:
+    int m_rows;
+    int m_cols;
+    std::pmr::vector<long long> m_counts;
+    std::pmr::vector<int> m_hits;
+    std::pmr::vector<SamplingTask*> m_tasks;
+
+      // We prevent a PlacementSampler object from being copied or assigned
+    PlacementSampler(const PlacementSampler&) = delete;
+    PlacementSampler& operator=(const PlacementSampler&) = delete;
+};
+
+#endif // PLACEMENTSAMPLER_INCLUDED
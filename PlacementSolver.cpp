@@ -0,0 +1,283 @@
+#include "PlacementSolver.h"
+#include "Bitboard.h"
+#include "PlacementKernels.h"
+#include "PlacementTable.h"
+#include "Arena.h"
+#include "globals.h"
+#include <vector>
+#include <algorithm>
+using namespace std;
+
+  // Positions are numbered 2*cell for across and 2*cell+1 for down, which is
+  // the order the search tries them in.  On boards of at most
+  // MAX_TABLE_CELLS cells they are looked up in each length's
+  // PlacementTable and checked with a mask test.
+
+class PlacementSearch
+{
+  public:
+    PlacementSearch(int nRows, int nCols, const Bitboard& free);
+    bool fits(int position, int length);
+    void mark(int position, int length, bool taken);
+    bool hasRoom(const pmr::vector<int>& lengths, const pmr::vector<int>& order, int firstLeft);
+
+  private:
+    int m_rows;
+    int m_cols;
+    bool m_standard;              // STANDARD_ROWS x STANDARD_COLS, so hasRoom can use masks
+    Bitboard m_avail;             // free cells no ship has taken yet
+    pmr::vector<int> m_runs;           // otherwise: by position, the untaken run through it that way
+    pmr::vector<int> m_longest;        // by run length, the cells whose longer run is that long
+    bool m_tabled;                // at most MAX_TABLE_CELLS cells, so fits can use tables
+    pmr::vector<const PlacementTable*> m_tables;   // by length, looked up when first needed
+
+    int usableCells(int length);
+    const PlacementTable& table(int length);
+    void setRun(int cell, int d, int run);
+    void rescan(int cell, int d);
+    void rescanNext(int cell, int d, int sign);
+};
+
+PlacementSearch::PlacementSearch(int nRows, int nCols, const Bitboard& free)
+ : m_rows(nRows), m_cols(nCols), m_standard(nRows == STANDARD_ROWS && nCols == STANDARD_COLS), m_avail(free), m_runs(gameMemory()), m_longest(gameMemory()), m_tabled(nRows * nCols <= MAX_TABLE_CELLS), m_tables(gameMemory())
+{
+    if ( m_standard )
+        return;
+    m_runs.assign(2 * nRows * nCols, 0);
+    m_longest.assign(max(nRows, nCols) + 1, 0);
+    m_longest[0] = nRows * nCols;
+    for ( int cell = 0; cell < nRows * nCols; cell++)
+    {
+        for ( int d = 0; d < 2; d++)
+        {
+            if ( m_runs[2*cell+d] == 0 )
+                rescan(cell, d);
+        }
+    }
+}
+
+const PlacementTable& PlacementSearch::table(int length)
+{
+    if ( length >= m_tables.size() )
+        m_tables.resize(length + 1, nullptr);
+    if ( m_tables[length] == nullptr )
+        m_tables[length] = PlacementTable::forShip(m_rows, m_cols, length);
+    return *m_tables[length];
+}
+
+bool PlacementSearch::fits(int position, int length)
+{
+    int cell = position / 2;
+    if ( m_tabled )
+    {
+        const PlacementTable& t = table(length);
+        int p = t.at(cell, Direction(position % 2));
+        return p != -1 && (t.mask(p) & ~cellMask(m_avail)) == 0;
+    }
+
+    int r = cell / m_cols;
+    int c = cell % m_cols;
+    if ( position % 2 == 0 )
+        return c + length <= m_cols && m_avail.allInRun(cell, length);
+
+    if ( r + length > m_rows )
+        return false;
+    for ( int i = 0; i < length; i++, cell += m_cols)
+    {
+        if ( !m_avail.test(cell) )
+            return false;
+    }
+    return true;
+}
+
+void PlacementSearch::mark(int position, int length, bool taken)
+{
+    int first = position / 2;
+    int along = position % 2;
+    int step = (along == 0 ? 1 : m_cols);
+    int last = first + (length - 1) * step;
+    for ( int cell = first; cell <= last; cell += step)
+    {
+        if ( taken )
+            m_avail.reset(cell);
+        else
+            m_avail.set(cell);
+    }
+    if ( m_standard )
+        return;
+
+      // Only the runs in the ship's own line and the lines it crosses change
+    if ( taken )
+    {
+        for ( int cell = first; cell <= last; cell += step)
+        {
+            setRun(cell, 0, 0);
+            setRun(cell, 1, 0);
+        }
+        rescanNext(first, along, -1);
+        rescanNext(last, along, 1);
+        for ( int cell = first; cell <= last; cell += step)
+        {
+            rescanNext(cell, 1 - along, -1);
+            rescanNext(cell, 1 - along, 1);
+        }
+    }
+    else
+    {
+        rescan(first, along);
+        for ( int cell = first; cell <= last; cell += step)
+            rescan(cell, 1 - along);
+    }
+}
+
+void PlacementSearch::setRun(int cell, int d, int run)
+{
+    int before = max(m_runs[2*cell], m_runs[2*cell+1]);
+    m_runs[2*cell+d] = run;
+    int after = max(m_runs[2*cell], m_runs[2*cell+1]);
+    m_longest[before]--;
+    m_longest[after]++;
+}
+
+  // Recount the run of untaken cells through cell, across if d is 0 and
+  // down if it is 1
+void PlacementSearch::rescan(int cell, int d)
+{
+    if ( !m_avail.test(cell) )
+    {
+        setRun(cell, d, 0);
+        return;
+    }
+    int step = (d == 0 ? 1 : m_cols);
+    int at = (d == 0 ? cell % m_cols : cell / m_cols);
+    int lineLength = (d == 0 ? m_cols : m_rows);
+    int start = at;
+    while ( start > 0 && m_avail.test(cell - (at - start + 1) * step) )
+        start--;
+    int end = at;
+    while ( end + 1 < lineLength && m_avail.test(cell + (end - at + 1) * step) )
+        end++;
+    for ( int i = start; i <= end; i++)
+        setRun(cell + (i - at) * step, d, end - start + 1);
+}
+
+  // Recount the run through cell's neighbour that way, if it has one
+void PlacementSearch::rescanNext(int cell, int d, int sign)
+{
+    int at = (d == 0 ? cell % m_cols : cell / m_cols) + sign;
+    if ( at >= 0 && at < (d == 0 ? m_cols : m_rows) )
+        rescan(cell + sign * (d == 0 ? 1 : m_cols), d);
+}
+
+  // How many untaken cells lie in an across or down run of at least length
+  // untaken cells
+int PlacementSearch::usableCells(int length)
+{
+    if ( m_standard )
+    {
+        if ( length > ShipMasks<STANDARD_ROWS, STANDARD_COLS>::MAX_LENGTH )
+            return 0;
+        CellMask avail = cellMask(m_avail);
+        CellMask usable = 0;
+        for ( int d = 0; d < 2; d++)
+        {
+            Direction dir = Direction(d);
+            usable |= coveredCells<STANDARD_ROWS, STANDARD_COLS>(
+                placementStarts<STANDARD_ROWS, STANDARD_COLS>(avail, length, dir), length, dir);
+        }
+        return __builtin_popcountll(uint64_t(usable)) + __builtin_popcountll(uint64_t(usable >> 64));
+    }
+
+    int n = 0;
+    for ( int run = length; run < m_longest.size(); run++)
+        n += m_longest[run];
+    return n;
+}
+
+bool PlacementSearch::hasRoom(const pmr::vector<int>& lengths, const pmr::vector<int>& order, int firstLeft)
+{
+      // order is longest first, so ships order[firstLeft..k] are exactly the
+      // remaining ships of length lengths[order[k]] or more.
+    int needed = 0;
+    for ( int k = firstLeft; k < order.size(); k++)
+    {
+        needed += lengths[order[k]];
+        bool lastOfLength = k + 1 == order.size() || lengths[order[k+1]] != lengths[order[k]];
+        if ( lastOfLength && usableCells(lengths[order[k]]) < needed )
+            return false;
+    }
+    return true;
+}
+
+bool solvePlacement(int nRows, int nCols, const Bitboard& free,
+                    const pmr::vector<int>& lengths, pmr::vector<ShipPlacement>& placements,
+                    long long nodeLimit)
+{
+    int n = lengths.size();
+    pmr::vector<int> order(n, gameMemory());
+    for ( int i = 0; i < n; i++)
+        order[i] = i;
+      // Longest first, keeping equal lengths in shipId order
+    sort(order.begin(), order.end(), [&lengths](int a, int b) {
+        return lengths[a] > lengths[b] || (lengths[a] == lengths[b] && a < b);
+    });
+
+    PlacementSearch search(nRows, nCols, free);
+    if ( !search.hasRoom(lengths, order, 0) )
+        return false;
+
+    int nPositions = 2 * nRows * nCols;
+    pmr::vector<int> position(n + 1, -1, gameMemory());   // position[d]: where ship order[d] is, or the last one tried
+    long long nodes = 0;
+    int d = 0;
+    position[0] = -1;
+
+    while ( d >= 0 )
+    {
+        if ( d == n )
+        {
+            placements.assign(n, ShipPlacement());
+            for ( int k = 0; k < n; k++)
+            {
+                int cell = position[k] / 2;
+                placements[order[k]].topOrLeft = Point(cell / nCols, cell % nCols);
+                placements[order[k]].dir = (position[k] % 2 == 0 ? HORIZONTAL : VERTICAL);
+            }
+            return true;
+        }
+
+        int length = lengths[order[d]];
+        bool advanced = false;
+        for ( int p = position[d] + 1; p < nPositions; p++)
+        {
+            if ( length == 1 && p % 2 == 1 )
+                continue;     // the same cell as the across position before it
+            if ( !search.fits(p, length) )
+                continue;
+            if ( nodeLimit > 0 && ++nodes > nodeLimit )
+                return false;
+            search.mark(p, length, true);
+            position[d] = p;
+            if ( search.hasRoom(lengths, order, d + 1) )
+            {
+                advanced = true;
+                break;
+            }
+            search.mark(p, length, false);
+        }
+
+        if ( advanced )
+        {
+            d++;
+              // an equal-length ship goes after the one before it
+            position[d] = (d < n && lengths[order[d]] == length ? position[d-1] : -1);
+        }
+        else
+        {
+            d--;
+            if ( d >= 0 )
+                search.mark(position[d], lengths[order[d]], false);
+        }
+    }
+    return false;
+}
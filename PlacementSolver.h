@@ -0,0 +1,32 @@
+#ifndef PLACEMENTSOLVER_INCLUDED
+#define PLACEMENTSOLVER_INCLUDED
+
+#include "globals.h"
+#include <vector>
+#include <memory_resource>
+
+class Bitboard;
+
+struct ShipPlacement
+{
+    Point topOrLeft;
+    Direction dir;
+};
+
+  // Find non-overlapping positions, all on cells set in free, for ships of
+  // the given lengths; placements[i] is where ship i goes.  The search runs
+  // longest ships first on an explicit stack, so its depth is the fleet
+  // size.  After each ship is placed it checks that the remaining ships
+  // still have room: for every remaining length L, the free cells lying in
+  // some run of at least L must be able to hold all the remaining ships of
+  // length L or more.  Ships of equal length are placed in increasing
+  // position order, so no arrangement is tried twice.
+  //
+  // Returns false if no placement exists, or if nodeLimit positions were
+  // tried first (0 means no limit).
+bool solvePlacement(int nRows, int nCols, const Bitboard& free,
+                    const std::pmr::vector<int>& lengths,
+                    std::pmr::vector<ShipPlacement>& placements,
+                    long long nodeLimit = 0);
+
+#endif // PLACEMENTSOLVER_INCLUDED
@@ -0,0 +1,105 @@
+#include "PlacementTable.h"
+#include <vector>
+#include <map>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <utility>
+using namespace std;
+
+const int STANDARD_LONGEST = STANDARD_ROWS > STANDARD_COLS ? STANDARD_ROWS : STANDARD_COLS;
+
+  // Owns the tables forShip hands out.  They are never freed, and come
+  // from the ordinary heap rather than gameMemory(), since they outlive
+  // every game; there are at most a few per board size of up to
+  // MAX_TABLE_CELLS cells.
+class PlacementTables
+{
+  public:
+    static const PlacementTable& standard(int length);
+    static const PlacementTable& built(int nRows, int nCols, int length);
+
+  private:
+    template<int Length>
+    static PlacementTable fromFixed()
+    {
+        const FixedPlacements<STANDARD_ROWS, STANDARD_COLS, Length>& f =
+            fixedPlacements<STANDARD_ROWS, STANDARD_COLS, Length>;
+        return PlacementTable(f.COUNT, Length, f.start, f.dir, f.masks, f.at, f.coverStart, f.cover);
+    }
+
+    template<int... Lengths>
+    static const PlacementTable& standardAt(int length, integer_sequence<int, Lengths...>)
+    {
+        static const PlacementTable tables[] = { fromFixed<Lengths>()... };
+        return tables[length];
+    }
+
+    struct Storage
+    {
+        vector<int> start;
+        vector<char> dir;
+        vector<CellMask> masks;
+        vector<int> at;
+        vector<int> coverStart;
+        vector<int> cover;
+        PlacementTable table;
+
+        Storage(int nRows, int nCols, int length);
+    };
+};
+
+PlacementTables::Storage::Storage(int nRows, int nCols, int length)
+ : start(placementCount(nRows, nCols, length)), dir(start.size()), masks(start.size()),
+   at(2 * nRows * nCols), coverStart(nRows * nCols + 1), cover(start.size() * (length > 0 ? length : 0)),
+   table(start.size(), length, start.data(), dir.data(), masks.data(), at.data(), coverStart.data(), cover.data())
+{
+    buildPlacements(nRows, nCols, length, start.data(), dir.data(), masks.data(), at.data(),
+                    coverStart.data(), cover.data());
+}
+
+const PlacementTable& PlacementTables::standard(int length)
+{
+    return standardAt(length, make_integer_sequence<int, STANDARD_LONGEST + 1>());
+}
+
+const PlacementTable& PlacementTables::built(int nRows, int nCols, int length)
+{
+    static mutex tablesMutex;
+    static map< array<int, 3>, unique_ptr<Storage> > tables;
+
+    lock_guard<mutex> lock(tablesMutex);
+    unique_ptr<Storage>& storage = tables[array<int, 3>{ nRows, nCols, length }];
+    if ( !storage )
+        storage.reset(new Storage(nRows, nCols, length));
+    return storage->table;
+}
+
+const PlacementTable* PlacementTable::forShip(int nRows, int nCols, int length)
+{
+    if ( nRows * nCols > MAX_TABLE_CELLS )
+        return nullptr;
+    if ( nRows == STANDARD_ROWS && nCols == STANDARD_COLS && length >= 0 && length <= STANDARD_LONGEST )
+        return &PlacementTables::standard(length);
+
+      // The tables this thread has looked up for the last board size it
+      // asked about, by length, so that it takes the lock once per table
+    struct Recent
+    {
+        int rows = -1;
+        int cols = -1;
+        vector<const PlacementTable*> byLength;
+    };
+    thread_local Recent recent;
+    if ( recent.rows != nRows || recent.cols != nCols )
+    {
+        recent.rows = nRows;
+        recent.cols = nCols;
+        recent.byLength.clear();
+    }
+    if ( length >= recent.byLength.size() )
+        recent.byLength.resize(length + 1, nullptr);
+    if ( recent.byLength[length] == nullptr )
+        recent.byLength[length] = &PlacementTables::built(nRows, nCols, length);
+    return recent.byLength[length];
+}
@@ -0,0 +1,151 @@
+#ifndef PLACEMENTTABLE_INCLUDED
+#define PLACEMENTTABLE_INCLUDED
+
+#include "globals.h"
+#include "FixedBoard.h"
+
+  // Tables are kept only for boards of at most this many cells, where a
+  // placement fits a CellMask.  On bigger boards they would cost memory in
+  // proportion to rows*cols*length and save little, so placements there are
+  // stepped through cell by cell instead.
+const int MAX_TABLE_CELLS = 128;
+
+  // Every placement of a ship of one length on a board of one size,
+  // numbered by top or left cell, across before down.  The table gives each
+  // placement's CellMask, the placement at each cell going each way, and
+  // for each cell the placements covering it, so checking and enumerating
+  // placements is a lookup and a mask test.  A ship of length 1 has only
+  // its across placements; going down finds the same ones.
+  //
+  // forShip hands out one table per (rows, cols, length) for the life of
+  // the program, shared by every thread, or nullptr if the board has more
+  // than MAX_TABLE_CELLS cells.  The standard board's are FixedPlacements,
+  // built at compile time; others are built on first use, and each thread
+  // remembers the ones it has looked up, so only its first lookup of each
+  // takes a lock.
+class PlacementTable
+{
+  public:
+    static const PlacementTable* forShip(int nRows, int nCols, int length);
+
+    int size() const { return m_size; }
+    int length() const { return m_length; }
+    int start(int p) const { return m_start[p]; }
+    Direction dir(int p) const { return Direction(m_dir[p]); }
+    CellMask mask(int p) const { return m_masks[p]; }
+      // The placement whose top or left end is cell, going dir, or -1 if
+      // it would run off the board
+    int at(int cell, Direction dir) const { return m_at[2 * cell + dir]; }
+      // The placements covering cell: those starting at it, then those
+      // starting one cell before it, and so on, across before down
+    const int* coverBegin(int cell) const { return m_cover + m_coverStart[cell]; }
+    const int* coverEnd(int cell) const { return m_cover + m_coverStart[cell+1]; }
+
+  private:
+    int m_size;
+    int m_length;
+    const int* m_start;
+    const char* m_dir;
+    const CellMask* m_masks;
+    const int* m_at;             // 2 per cell
+    const int* m_coverStart;     // rows*cols + 1 offsets into m_cover
+    const int* m_cover;
+
+    PlacementTable(int size, int length, const int* start, const char* dir,
+                   const CellMask* masks, const int* at, const int* coverStart, const int* cover)
+     : m_size(size), m_length(length), m_start(start), m_dir(dir),
+       m_masks(masks), m_at(at), m_coverStart(coverStart), m_cover(cover)
+    {}
+    friend class PlacementTables;
+};
+
+  // How many placements a ship of length has on a board of nRows x nCols
+constexpr int placementCount(int nRows, int nCols, int length)
+{
+    if ( length < 1 || (length > nRows && length > nCols) )
+        return 0;
+    int across = (length <= nCols ? nRows * (nCols - length + 1) : 0);
+    int down = (length <= nRows ? nCols * (nRows - length + 1) : 0);
+    return length == 1 ? across : across + down;
+}
+
+  // Fill in the arrays of a PlacementTable (see above) for a board of at
+  // most MAX_TABLE_CELLS cells.  at needs 2*nRows*nCols entries, coverStart
+  // nRows*nCols + 1, and the others placementCount entries, times length
+  // for cover.
+constexpr void buildPlacements(int nRows, int nCols, int length, int* start, char* dir,
+                               CellMask* masks, int* at, int* coverStart, int* cover)
+{
+    int n = 0;
+    for ( int cell = 0; cell < nRows * nCols; cell++)
+    {
+        int r = cell / nCols;
+        int c = cell % nCols;
+        at[2 * cell] = -1;
+        at[2 * cell + 1] = -1;
+        if ( length < 1 )
+            continue;
+        for ( int d = 0; d < (length == 1 ? 1 : 2); d++)
+        {
+            if ( (d == 0 ? c : r) + length > (d == 0 ? nCols : nRows) )
+                continue;
+            int step = (d == 0 ? 1 : nCols);
+            start[n] = cell;
+            dir[n] = char(d);
+            masks[n] = 0;
+            for ( int i = 0; i < length; i++)
+                masks[n] |= CellMask(1) << (cell + i * step);
+            at[2 * cell + d] = n;
+            n++;
+        }
+        if ( length == 1 )
+            at[2 * cell + 1] = at[2 * cell];
+    }
+
+    int k = 0;
+    for ( int cell = 0; cell < nRows * nCols; cell++)
+    {
+        coverStart[cell] = k;
+        for ( int back = 0; back < length; back++)
+        {
+            for ( int d = 0; d < (length == 1 ? 1 : 2); d++)
+            {
+                int step = (d == 0 ? 1 : nCols);
+                int first = cell - back * step;
+                if ( (d == 0 ? cell % nCols : cell / nCols) < back )
+                    continue;
+                if ( at[2 * first + d] != -1 )
+                    cover[k++] = at[2 * first + d];
+            }
+        }
+    }
+    coverStart[nRows * nCols] = k;
+}
+
+  // The arrays of the table for a ship of length Length on a Rows x Cols
+  // board, computed by the compiler
+template<int Rows, int Cols, int Length>
+struct FixedPlacements
+{
+    static_assert(Rows * Cols <= MAX_TABLE_CELLS, "cell masks hold at most 128 cells");
+    static constexpr int COUNT = placementCount(Rows, Cols, Length);
+      // (arrays of at least one entry, for lengths with no placements)
+    static constexpr int SIZE = COUNT > 0 ? COUNT : 1;
+
+    int start[SIZE];
+    char dir[SIZE];
+    CellMask masks[SIZE];
+    int at[2 * Rows * Cols];
+    int coverStart[Rows * Cols + 1];
+    int cover[SIZE * (Length > 0 ? Length : 1)];
+
+    constexpr FixedPlacements() : start(), dir(), masks(), at(), coverStart(), cover()
+    {
+        buildPlacements(Rows, Cols, Length, start, dir, masks, at, coverStart, cover);
+    }
+};
+
+template<int Rows, int Cols, int Length>
+constexpr FixedPlacements<Rows, Cols, Length> fixedPlacements {};
+
+#endif // PLACEMENTTABLE_INCLUDED
@@ -1,30 +1,176 @@
 #include "Player.h"
 #include "Board.h"
 #include "Game.h"
+#include "DensityMap.h"
+#include "PlacementPrior.h"
+#include "PlacementSampler.h"
+#include "LayoutSearch.h"
+#include "EndgameSolver.h"
+#include "HitTracker.h"
+#include "ThreadPool.h"
+#include "PlacementSolver.h"
+#include "Bitboard.h"
+#include "FixedBoard.h"
 #include "globals.h"
 #include <iostream>
 #include <string>
 #include <vector>
 #include <algorithm>
-#include <queue>
+#include <memory_resource>
+#include <cstdlib>
 using namespace std;
 
 
-void setAvailablePts( vector<Point> &vec, int nRows, int nCols)
+  // A set of cells of a board, kept as a list in no particular order plus
+  // each cell's position in the list (-1 if absent), so testing, removing
+  // and drawing a cell at random each take constant time.
+class CellSet
 {
-    for ( int r = 0; r < nRows; r++)
-        for ( int c = 0; c < nCols; c++)
-            vec.push_back(Point(r,c));
-}
+  public:
+    CellSet() : m_cells(gameMemory()), m_position(gameMemory()) {}
+      // Make the set hold every cell from 0 to nCells-1
+    void fill(int nCells)
+    {
+        m_cells.resize(nCells);
+        m_position.resize(nCells);
+        for ( int i = 0; i < nCells; i++)
+        {
+            m_cells[i] = i;
+            m_position[i] = i;
+        }
+    }
+    int size() const { return m_cells.size(); }
+    bool empty() const { return m_cells.empty(); }
+    int at(int i) const { return m_cells[i]; }
+    bool contains(int cell) const { return m_position[cell] != -1; }
+      // Remove cell by moving the last cell listed into its place
+    void remove(int cell)
+    {
+        int i = m_position[cell];
+        if ( i == -1 )
+            return;
+        m_cells[i] = m_cells.back();
+        m_position[m_cells[i]] = i;
+        m_cells.pop_back();
+        m_position[cell] = -1;
+    }
+
+  private:
+    pmr::vector<int> m_cells;
+    pmr::vector<int> m_position;   // by cell
+};
 
-int findIfAvailable(const vector<Point>& vec, const Point& target)
+  // Cells of a board, each with a score, kept in a binary heap with the
+  // highest score on top (the lowest cell on a tie).  Each cell's place in
+  // the heap is kept too, so rescoring or removing a cell moves just that
+  // entry, and the heap never holds stale ones.
+class CellHeap
 {
-    for ( int i = 0;  i < vec.size(); i++)
+  public:
+    CellHeap() : m_heap(gameMemory()), m_position(gameMemory()), m_score(gameMemory()) {}
+      // Empty the heap, for cells from 0 to nCells-1
+    void clear(int nCells)
+    {
+        m_heap.clear();
+        m_position.assign(nCells, -1);
+        m_score.assign(nCells, 0);
+    }
+    bool empty() const { return m_heap.empty(); }
+    int top() const { return m_heap[0]; }
+      // Add cell with the given score, or change its score if it is there
+    void set(int cell, int score)
+    {
+        int i = m_position[cell];
+        if ( i == -1 )
+        {
+            i = m_heap.size();
+            m_heap.push_back(cell);
+            m_position[cell] = i;
+        }
+        else if ( score == m_score[cell] )
+            return;
+        m_score[cell] = score;
+        siftDown(siftUp(i));
+    }
+    void remove(int cell)
+    {
+        int i = m_position[cell];
+        if ( i == -1 )
+            return;
+        m_position[cell] = -1;
+        int last = m_heap.back();
+        m_heap.pop_back();
+        if ( last == cell )
+            return;
+        m_heap[i] = last;
+        m_position[last] = i;
+        siftDown(siftUp(i));
+    }
+
+  private:
+    pmr::vector<int> m_heap;       // cells
+    pmr::vector<int> m_position;   // by cell; -1 if not in the heap
+    pmr::vector<int> m_score;      // by cell
+
+    bool above(int a, int b) const
+    {
+        return m_score[a] > m_score[b] || (m_score[a] == m_score[b] && a < b);
+    }
+    void put(int i, int cell)
+    {
+        m_heap[i] = cell;
+        m_position[cell] = i;
+    }
+    int siftUp(int i)
+    {
+        int cell = m_heap[i];
+        for ( ; i > 0 && above(cell, m_heap[(i-1)/2]); i = (i-1)/2)
+            put(i, m_heap[(i-1)/2]);
+        put(i, cell);
+        return i;
+    }
+    void siftDown(int i)
+    {
+        int cell = m_heap[i];
+        for ( ;; )
+        {
+            int child = 2*i + 1;
+            if ( child >= m_heap.size() )
+                break;
+            if ( child + 1 < m_heap.size() && above(m_heap[child+1], m_heap[child]) )
+                child++;
+            if ( !above(m_heap[child], cell) )
+                break;
+            put(i, m_heap[child]);
+            i = child;
+        }
+        put(i, cell);
+    }
+};
+
+  // Place the whole fleet on b's free cells, using the placement solver.
+  // Returns false if it finds no way to (or gives up after nodeLimit
+  // positions, when nodeLimit is positive); b is unchanged then.
+bool placeFleet(Board& b, const Game& g, long long nodeLimit)
+{
+    Bitboard free;
+    b.freeCells(free);
+    pmr::vector<int> lengths(gameMemory());
+    for ( int i = 0; i < g.nShips(); i++)
+        lengths.push_back(g.shipLength(i));
+    pmr::vector<ShipPlacement> placements(gameMemory());
+    if ( !solvePlacement(g.rows(), g.cols(), free, lengths, placements, nodeLimit) )
+        return false;
+    for ( int i = 0; i < g.nShips(); i++)
     {
-        if ( vec[i].r == target.r && vec[i].c == target.c )
-            return i;
+        if ( !b.placeShip(placements[i].topOrLeft, i, placements[i].dir) )
+        {
+            for ( int k = 0; k < i; k++)
+                b.unplaceShip(placements[k].topOrLeft, k, placements[k].dir);
+            return false;
+        }
     }
-    return -1;
+    return true;
 }
 
 //*********************************************************************
@@ -40,6 +186,7 @@ public:
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
                                     bool shipDestroyed, int shipId);
     virtual void recordAttackByOpponent(Point p);
+    virtual void reset() { m_lastCellAttacked = Point(0, 0); }
 private:
     Point m_lastCellAttacked;
 };
@@ -107,6 +254,7 @@ public:
     virtual Point recommendAttack();
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)  {  }
     virtual void recordAttackByOpponent(Point p) {  }
+    virtual void reset() {  }
     virtual bool isHuman() const { return true; }
 private:
     
@@ -208,115 +356,92 @@ Point HumanPlayer::recommendAttack(){
 class MediocrePlayer : public Player
 {
 public:
-    MediocrePlayer(string nm, const Game& g) : Player(nm, g), currentState(1), transitionPt(0,0)
-    {setAvailablePts(availablePts, g.rows(), g.cols());}
+    MediocrePlayer(string nm, const Game& g) : Player(nm, g), currentState(1), transitionPt(0,0), nCross(0)
+    {reset();}
     virtual bool placeShips(Board& b);
     virtual Point recommendAttack();
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
                                     bool shipDestroyed, int shipId);
     virtual void recordAttackByOpponent(Point p) {  };
+    virtual void reset();
 private:
     int currentState;
     Point transitionPt;
-    vector<Point> availablePts;
+    CellSet availablePts;
+      // The cells on the board within 4 of transitionPt along its row or
+      // column, other than transitionPt itself
+    int crossCells[16];
+    int nCross;
     
     // helper functions:
-    bool placeShipsHelper (Board& b, const int& n, const int& cellsAttempted ) const;
-    Point randomPointFromSet ( const Point& center );
-    // int findIfAvailable ( const Point& target ) const;
+    bool placeShipsHelper (Board& b ) const;
+    void setCross ( const Point& center );
 };
 
 
+void MediocrePlayer::reset()
+{
+    currentState = 1;
+    transitionPt = Point(0,0);
+    nCross = 0;
+    availablePts.fill(game().rows() * game().cols());
+}
+
+  // Most positions the solver tries per block pattern before moving on
+const long long MEDIOCRE_NODE_LIMIT = 100000;
+
 bool MediocrePlayer::placeShips(Board& b)
 {
     for ( int i = 0; i < 50; i++)
     {
         b.block();
-        
-        if ( placeShipsHelper(b, game().nShips(), 0) )
-        {
-            b.unblock();
-            return true;
-        }
+        bool placed = placeShipsHelper(b);
         b.unblock();
+        if ( placed )
+            return true;
     }
 
-    b.unblock();
-    return false;
+    return placeFleet(b, game(), 0);   // no block pattern left room; use the open board
 }
 
-bool MediocrePlayer::placeShipsHelper(Board &b, const int& n, const int& cellsAttempted) const
+bool MediocrePlayer::placeShipsHelper(Board &b) const
 {
-    if ( n == 0 )
-        return true;
-    if ( cellsAttempted >= game().rows() * game().cols() )   // if impossible with this block configuration
-        return false;
-    
-    int row = cellsAttempted / game().cols();      // starts at (0,0), then (0,1) - (0,9), then (1,0) - (1,9)...
-    int col = cellsAttempted % game().cols();
-    
-    Direction dir;
-    
-    if ( b.placeShip(Point(row,col), n-1, HORIZONTAL) )
-        dir = HORIZONTAL;
-    else if ( b.placeShip(Point(row,col), n-1, VERTICAL))
-        dir = VERTICAL;
-    else
-        return placeShipsHelper(b, n, cellsAttempted + 1);
-    
-    if ( placeShipsHelper(b, n - 1, 0))
-        return true;
-    else
-    {
-        b.unplaceShip(Point(row,col), n-1, dir);
-        return placeShipsHelper(b, n, cellsAttempted + 1);
-    }
-    
+    return placeFleet(b, game(), MEDIOCRE_NODE_LIMIT);
 }
 
 
 
 Point MediocrePlayer::recommendAttack()
 {
-    Point x;
-    int n;
+    int cell;
     
     if ( availablePts.empty() )
         return Point(0,0);
     
     if ( currentState == 1 )
-    {
-        n = randInt(availablePts.size());
-        x = availablePts.at(n);
-    }
+        cell = availablePts.at(randInt(availablePts.size()));
     else                            /////// ( currentState == 2 )
     {
-        
-        bool allTaken = true;
-        
-        for ( int i = 0; i < 9; i++)
+          // Any cell on the cross not yet shot, each as likely
+        int open[16];
+        int nOpen = 0;
+        for ( int i = 0; i < nCross; i++)
         {
-            if ( findIfAvailable(availablePts, Point(transitionPt.r - 4 + i, transitionPt.c)) != -1 || findIfAvailable(availablePts, Point(transitionPt.r, transitionPt.c - 4 + i)) != -1 )
-            {
-                allTaken = false;
-                break;
-            }
+            if ( availablePts.contains(crossCells[i]) )
+                open[nOpen++] = crossCells[i];
         }
         
-        if ( allTaken )
+        if ( nOpen == 0 )
         {
             currentState = 1;
             return recommendAttack();
         }
         
-        do {
-            x = randomPointFromSet(transitionPt);
-            n = findIfAvailable(availablePts, x);
-        } while ( n == -1 );
+        cell = open[randInt(nOpen)];
     }
     
-    availablePts.erase(availablePts.begin() + n);
-    return x;
+    availablePts.remove(cell);
+    return Point(cell / game().cols(), cell % game().cols());
 }
 
 void MediocrePlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
@@ -340,6 +465,7 @@ void MediocrePlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
         {
             currentState = 2;
             transitionPt = p;
+            setCross(p);
             return;
         }
     }
@@ -359,11 +485,18 @@ void MediocrePlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
     }
 }
 
-Point MediocrePlayer::randomPointFromSet ( const Point& center )
+void MediocrePlayer::setCross ( const Point& center )
 {
-    if ( randInt(2) == 0)
-        return Point(center.r, center.c - 4 + randInt(9));
-    return Point(center.r - 4 + randInt(9), center.c);
+    nCross = 0;
+    for ( int d = -4; d <= 4; d++)
+    {
+        if ( d == 0 )
+            continue;
+        if ( center.c + d >= 0 && center.c + d < game().cols() )
+            crossCells[nCross++] = center.r * game().cols() + center.c + d;
+        if ( center.r + d >= 0 && center.r + d < game().rows() )
+            crossCells[nCross++] = (center.r + d) * game().cols() + center.c;
+    }
 }
 
 
@@ -376,56 +509,130 @@ Point MediocrePlayer::randomPointFromSet ( const Point& center )
 class GoodPlayer : public Player
 {
 public:
-    GoodPlayer(string nm, const Game& g);
+      // How recommendAttack picks cells: HEURISTIC hunts with calcProb and
+      // follows hits with a HitTracker; DENSITY shoots wherever
+      // the most placements of the remaining ships overlap (see DensityMap);
+      // MONTE_CARLO shoots wherever the most randomly drawn consistent
+      // fleets overlap, drawing samplesPerTurn fleets, or as many as fit in
+      // msPerTurn if that is positive (see PlacementSampler).
+    enum AttackPolicy { HEURISTIC, DENSITY, MONTE_CARLO };
+      // With usePrior, the player keeps a PlacementPrior of where its
+      // opponent's ships have been, across the games of a match, and weighs
+      // its density scores with it while hunting.  With placeAway, it keeps
+      // track of where its opponent shoots early in a game, and once it has
+      // seen a game, places its fleet with a LayoutSearch of layoutsPerGame
+      // layouts, or as many as fit in layoutMs if that is positive.
+      //
+      // Whatever the policy, once few enough fleets agree with what it
+      // knows, the player finishes the game with an EndgameSolver, except
+      // while a prior is steering its hunt.
+    GoodPlayer(string nm, const Game& g, AttackPolicy policy = HEURISTIC,
+               int samplesPerTurn = 2000, int msPerTurn = 0, bool usePrior = false,
+               bool placeAway = false, int layoutsPerGame = 2048, int layoutMs = 0);
     virtual bool placeShips(Board& b);
     virtual Point recommendAttack();
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
                                     bool shipDestroyed, int shipId);
     virtual void recordAttackByOpponent(Point p);
+    virtual void reset();
+    virtual bool learnsAcrossGames() const { return usePrior || placeAway; }
 private:
-    int currentState;
-    char oppGrid[MAXROWS][MAXCOLS];
-    Point transitionPt;
-    Direction dir;
-    Point topOrLeft;
-    Point botOrRight;
-    
-    queue<Point> ptsToExplore;
+    pmr::vector<char> oppGrid;   // rows()*cols() cells, row by row
+    struct Runs { int left, right, up, down; };
+    pmr::vector<Runs> runs;      // '.' cells in an unbroken line beside each cell, each way
     
     int biggerShip ( const int& id1, const int& id2) const;
     int calcProb(const Point& p, const int& biggestShipLeft ) const;
     
-    bool collateral;
-    vector<int> shipLengths;
-    void mostProbableFirst (const Point& p, Point& p1, Point& p2, Point& p3, Point& p4 ) const;
+    pmr::vector<int> shipLengths;
     int hitCount;
-    
-    bool justPlaceThemIfPossible(Board& b, int n, int cellsAttempted );
-    vector<Point> openPoints;
+    HitTracker hits;
+    
+    bool justPlaceThemIfPossible(Board& b );
+    char& oppAt(int r, int c) { return oppGrid[r * game().cols() + c]; }
+    char oppAt(int r, int c) const { return oppGrid[r * game().cols() + c]; }
+    CellHeap heat;                             // calcProb of every '.' cell
+    int heatBiggest;                           // the biggest ship length heat was computed for
+    void rebuildHeat();
+    void updateHeatAround(const Point& p);
+    void updateHeatLine(const Point& p, int dr, int dc);
     Point bestMove();
     int shipsGone;
+    int sunkCells;               // cells marked 'S'; shipsGone once every sunk ship is pinned down
+    
+    AttackPolicy attackPolicy;
+    DensityMap density;
+    bool densityCurrent;         // density's scores are for oppGrid and shipLengths as they are
+    Point densityMove();
+    PlacementSampler sampler;
+    int samplesPerTurn;
+    int msPerTurn;
+    Point monteCarloMove();
+    bool usePrior;
+    PlacementPrior opponentPrior;
+    bool huntingByPrior() const { return usePrior && opponentPrior.games() > 0 && hitCount == shipsGone; }
+    pmr::vector<long long> opponentShots;  // early shots at each cell, earliest weighing most
+    int opponentShotCount;                 // shots the opponent has taken this game
+    int opponentGames;                     // games opponentShots has shots from
+    bool placeAway;
+    LayoutSearch layoutSearch;
+    int layoutsPerGame;
+    int layoutMs;
+    bool placeAwayFromShots(Board& b);
+    EndgameSolver endgame;
+    int endgameMove();
+    Point heuristicMove();
 };
 
-GoodPlayer::GoodPlayer(string nm, const Game& g) : Player(nm, g), currentState(1), transitionPt(Point(0,0)), dir(HORIZONTAL), topOrLeft(Point(0,0)), botOrRight(Point(0,1)), collateral(false), hitCount(0), shipsGone(0)
+int fleetCells(const Game& g)
 {
-    for ( int r = 0; r < g.rows(); r++)
-        for ( int c = 0; c < g.cols(); c++)
-        {
-            oppGrid[r][c] = '.';
-            openPoints.push_back(Point(r,c));
-        }
-    
+    int n = 0;
+    for ( int i = 0; i < g.nShips(); i++)
+        n += g.shipLength(i);
+    return n;
+}
+
+GoodPlayer::GoodPlayer(string nm, const Game& g, AttackPolicy policy, int samples, int ms, bool prior, bool away, int layouts, int layoutBudget) : Player(nm, g), oppGrid(g.rows() * g.cols(), '.', gameMemory()), runs(g.rows() * g.cols(), Runs(), gameMemory()), shipLengths(gameMemory()), hitCount(0), hits(g.rows(), g.cols()), heatBiggest(0), shipsGone(0), sunkCells(0), attackPolicy(policy), density(g.rows(), g.cols()), densityCurrent(false), sampler(g.rows(), g.cols()), samplesPerTurn(samples), msPerTurn(ms), usePrior(prior), opponentPrior(g.rows(), g.cols(), fleetCells(g)), opponentShots(g.rows() * g.cols(), 0, gameMemory()), opponentShotCount(0), opponentGames(0), placeAway(away), layoutSearch(g.rows(), g.cols()), layoutsPerGame(layouts), layoutMs(layoutBudget), endgame(g.rows(), g.cols())
+{
+    reset();
+}
+
+void GoodPlayer::reset()
+{
+    if ( usePrior )
+        opponentPrior.addGame(oppGrid);   // what the game just ended showed
+    if ( placeAway && opponentShotCount > 0 )
+        opponentGames++;
+    opponentShotCount = 0;
+    for ( int i = 0; i < oppGrid.size(); i++)
+    {
+        oppGrid[i] = '.';
+        int r = i / game().cols();
+        int c = i % game().cols();
+        runs[i] = Runs { c, game().cols() - 1 - c, r, game().rows() - 1 - r };
+    }
+    hitCount = 0;
+    hits.reset();
+    shipsGone = 0;
+    sunkCells = 0;
+    shipLengths.clear();
     for ( int i = 0; i < game().nShips(); i++)
     {
         shipLengths.push_back(game().shipLength(i));
     }
     sort(shipLengths.begin(), shipLengths.end() );
-    
+    heatBiggest = 0;      // so bestMove rebuilds heat
+    heat.clear(game().rows() * game().cols());
+    densityCurrent = false;
+    endgame.end();
 }
 
 bool GoodPlayer::placeShips(Board& b)    /////////////////////////////////////////////////////////////
 {
-    vector<Point> shipLocations;
+    if ( placeAway && opponentGames > 0 && placeAwayFromShots(b) )
+        return true;
+    
+    pmr::vector<Point> shipLocations(gameMemory());
     int idOfBiggest = 0;
     for ( int i = 0; i < game().nShips(); i++)
     {
@@ -437,7 +644,7 @@ bool GoodPlayer::placeShips(Board& b)    ///////////////////////////////////////
     Direction dir = HORIZONTAL;
     
     if ( !b.placeShip(Point(placeRow, placeCol), idOfBiggest, HORIZONTAL) )
-        return justPlaceThemIfPossible(b, game().nShips(), 0); /////////////////
+        return justPlaceThemIfPossible(b); /////////////////
     else
         shipLocations.push_back(Point(placeRow,placeCol));
     
@@ -454,20 +661,13 @@ bool GoodPlayer::placeShips(Board& b)    ///////////////////////////////////////
             {
                 if ( !b.placeShip(Point(game().rows()/2 + 1, 0 ), i, VERTICAL))
                 {
-                    int i = 0;
+                    int tries = 0;
                     while ( !b.placeShip(game().randomPoint(), i, dir)) {
-                        i++;
-                        if ( i > 5 )
+                        tries++;
+                        if ( tries > 5 )
                         {
-                            for ( int i = 0; i < shipLocations.size(); i++)
-                            {
-                                for ( int n = 0 ; n < game().nShips(); n++)
-                                {
-                                    if (b.unplaceShip(shipLocations[i], n, HORIZONTAL) || b.unplaceShip(shipLocations[i], n, VERTICAL) )
-                                        break;
-                                }
-                            }
-                            return justPlaceThemIfPossible(b, game().nShips(), 0);
+                            b.clear();   // start over from an empty board
+                            return justPlaceThemIfPossible(b);
                         }
                     };
                 }
@@ -492,320 +692,133 @@ int GoodPlayer::biggerShip ( const int& id1, const int& id2) const
     return id2;
 }
 
-bool GoodPlayer::justPlaceThemIfPossible(Board& b, int n, int cellsAttempted )
+bool GoodPlayer::justPlaceThemIfPossible(Board& b )
 {
-    if ( n == 0 )
-        return true;
-    if ( cellsAttempted >= game().rows() * game().cols() )   // if impossible with this block configuration
-        return false;
-    
-    int row = cellsAttempted / game().cols();      // starts at (0,0), then (0,1) - (0,9), then (1,0) - (1,9)...
-    int col = cellsAttempted % game().cols();
-    
-    Direction dir;
-    
-    if ( b.placeShip(Point(row,col), n-1, HORIZONTAL) )
-        dir = HORIZONTAL;
-    else if ( b.placeShip(Point(row,col), n-1, VERTICAL))
-        dir = VERTICAL;
-    else
-        return justPlaceThemIfPossible(b, n, cellsAttempted + 1);
-    
-    if ( justPlaceThemIfPossible(b, n - 1, 0))
-        return true;
-    else
-    {
-        b.unplaceShip(Point(row,col), n-1, dir);
-        return justPlaceThemIfPossible(b, n, cellsAttempted + 1);
-    }
-    
+    return placeFleet(b, game(), 0);
 }
 
 
 
 Point GoodPlayer::recommendAttack()  //// shiplengths remaining, pt surrounded by o
 {
-    if ( currentState == 1)
-    {
-        Point a;
-        do{
-            a = bestMove();
-        }
-        while ( oppGrid[a.r][a.c] != '.') ;
-        return a;
-        
-    }
-    
-    if ( currentState == 2)
-    {
-        Point a1, a2, a3, a4;
-        mostProbableFirst(ptsToExplore.front(), a1, a2, a3, a4);
-        
-        if ( a1.r >= 0 && a1.r < game().rows() && a1.c >= 0 && a1.c < game().cols() && oppGrid[a1.r][a1.c] == '.')
-            return Point(a1.r,a1.c);
-        else if ( a2.r >= 0 && a2.r < game().rows() && a2.c >= 0 && a2.c < game().cols() && oppGrid[a2.r][a2.c] == '.' )
-            return Point(a2.r,a2.c);
-        else if ( a3.r >= 0 && a3.r < game().rows() && a3.c >= 0 && a3.c < game().cols() && oppGrid[a3.r][a3.c] == '.' )
-            return Point(a3.r,a3.c);
-        else if ( a4.r >= 0 && a4.r < game().rows() && a4.c >= 0 && a4.c < game().cols() && oppGrid[a4.r][a4.c] == '.')
-            return Point(a4.r,a4.c);
-        else
-        {
-            ptsToExplore.pop();
-            if ( !ptsToExplore.empty() )
-            {
-                return recommendAttack();
-            }
-            else
-            {
-                currentState = 1;
-                return recommendAttack();
-            }
-        }
-    }
-    
-    if ( currentState == 3 )
-    {
-        if ( dir == HORIZONTAL )
-        {
-            if ( botOrRight.c + 1 < game().cols() && oppGrid[botOrRight.r][botOrRight.c+1] == '.' )
-                return Point(botOrRight.r, botOrRight.c + 1);
-            else if ( topOrLeft.c -1 >= 0 && oppGrid[topOrLeft.r][topOrLeft.c-1] == '.')
-                return Point(topOrLeft.r, topOrLeft.c - 1);
-            else
-            {
-                collateral = true;
-                currentState = 2;
-                return recommendAttack();    /// check to make sure id is the one that was hit...if not, keep going
-            }
-        }
-        if ( dir == VERTICAL )
-        {
-            if ( botOrRight.r + 1 < game().rows() && oppGrid[botOrRight.r+1][botOrRight.c] == '.' )
-                return Point(botOrRight.r+1, botOrRight.c);
-            else if ( topOrLeft.r-1 >= 0 && oppGrid[topOrLeft.r-1][topOrLeft.c] == '.')
-                return Point(topOrLeft.r-1, topOrLeft.c);
-            else
-            {
-                collateral = true;
-                currentState = 2;
-                return recommendAttack();
-            }
-        }
-        
-    }
-    
-    return game().randomPoint(); //never actually executed
+    int cell = endgameMove();
+    if ( cell != -1 )
+        return Point(cell / game().cols(), cell % game().cols());
+    if ( attackPolicy == DENSITY )
+        return densityMove();
+    if ( attackPolicy == MONTE_CARLO )
+        return monteCarloMove();
+    return heuristicMove();
 }
 
-
-
-void GoodPlayer::mostProbableFirst (const Point& p, Point& d1, Point& d2, Point& d3, Point& d4 ) const
+  // The cell the EndgameSolver would shoot, or -1 to play on as usual.  It
+  // is started only when every sunk ship has been marked 'S', since its
+  // fleets must account for every 'X' cell, and not while hunting for more
+  // than one ship, when there are always too many fleets to list.
+int GoodPlayer::endgameMove()
 {
-    Point left (p.r, p.c-1);
-    Point up (p.r-1, p.c);
-    Point right (p.r, p.c+1);
-    Point down (p.r+1, p.c);
-    if (calcProb(left, shipLengths.back()) > calcProb(right, shipLengths.back()) )
-    {
-        d1 = left;
-        d3 = right;
-    }
-    else
-    {
-        d1 = right;
-        d3 = left;
-    }
-    if ( calcProb(up, shipLengths.back() ) > calcProb(down, shipLengths.back())  )
+    if ( huntingByPrior() )      // the hunt follows the prior, not a uniform guess
+        return -1;
+    if ( !endgame.active() )
     {
-        d2 = up;
-        d4 = down;
+        if ( !endgame.boardFits() || (hitCount == shipsGone && shipLengths.size() > 1) )
+            return -1;
+        if ( sunkCells != shipsGone || !endgame.begin(oppGrid, shipLengths) )
+            return -1;
     }
-    else
+    return endgame.bestCell();
+}
+
+  // Follow up any hits not yet known to be from sunk ships, and otherwise
+  // hunt by calcProb
+Point GoodPlayer::heuristicMove()
+{
+    if ( hitCount != shipsGone )
     {
-        d2 = down;
-        d4 = up;
+        int cell = hits.bestCell(oppGrid, shipLengths);
+        if ( cell != -1 )
+            return Point(cell / game().cols(), cell % game().cols());
     }
-    
+    return bestMove();
 }
 
 void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
 {
+    if ( validShot && endgame.active() )
+        endgame.record(p.r * game().cols() + p.c, shotHit, shipDestroyed ? game().shipLength(shipId) : 0);
     if (validShot)
     {
         if ( shotHit )
         {
-            oppGrid[p.r][p.c] = 'X';
+            oppAt(p.r, p.c) = 'X';
             hitCount++;
+            hits.recordHit(p.r * game().cols() + p.c);
         }
         else
-            oppGrid[p.r][p.c] = 'o';
+            oppAt(p.r, p.c) = 'o';
+        heat.remove(p.r * game().cols() + p.c);
+        updateHeatAround(p);
+        if ( densityCurrent && !shipDestroyed )
+            density.recount(oppGrid, shipLengths, p.r * game().cols() + p.c);
     }
     
     if ( shipDestroyed )
     {
+        if ( markSunkShip(oppGrid, game().rows(), game().cols(), p.r * game().cols() + p.c, game().shipLength(shipId)) )
+            sunkCells += game().shipLength(shipId);
+        hits.recordSunk(oppGrid);
         shipsGone += game().shipLength(shipId);
-        if ( shipsGone != hitCount )
-            collateral = true;
-        else
-            collateral = false;
-    }
-    
-    if ( currentState == 1)
-    {
-        if ( shipDestroyed )
-        {
-            shipLengths.erase(find(shipLengths.begin(), shipLengths.end(), game().shipLength(shipId)));
-            return;
-        }
-        else if (shotHit)
-        {
-            transitionPt = p;
-            topOrLeft = p;
-            currentState = 2;
-            ptsToExplore.push(p);
-            return;
-        }
-        else
-            return;
-        
-    }
-    
-    if ( currentState == 2)
-    {
-        if ( shipDestroyed )
-        {
-            shipLengths.erase(find(shipLengths.begin(), shipLengths.end(), game().shipLength(shipId)));
-            if (!collateral)
-                currentState  = 1;
-            return;
-        }
-        else if (shotHit)
-        {
-            if ( transitionPt.r == p.r-1 || transitionPt.r == p.r+1)
-            {
-                dir = VERTICAL;
-                if ( p.r - 1 == transitionPt.r )
-                    botOrRight = p;
-                else
-                {
-                    topOrLeft = p;
-                    botOrRight = transitionPt;
-                }
-            }
-            else if ( transitionPt.c == p.c-1 || transitionPt.c == p.c+1)
-            {
-                dir = HORIZONTAL;
-                if ( p.c - 1 == transitionPt.c )
-                    botOrRight = p;
-                else
-                {   topOrLeft = p;
-                    botOrRight = transitionPt;
-                }
-            }
-            currentState = 3;
-        }
-        else
-            return;
+        shipLengths.erase(find(shipLengths.begin(), shipLengths.end(), game().shipLength(shipId)));
+        densityCurrent = false;    // the fleet left, and any cells now 'S', change every line
     }
-    
-    if ( currentState == 3 )
+}
+void GoodPlayer::recordAttackByOpponent(Point p)
+{
+    if ( !placeAway )
+        return;
+      // Only the first half of the board's worth of shots count, the
+      // earliest most, since those are the ones a layout can dodge.
+    int earlyShots = int(opponentShots.size()) / 2;
+    opponentShotCount++;
+    if ( opponentShotCount <= earlyShots && game().isValid(p) )
+        opponentShots[p.r * game().cols() + p.c] += earlyShots + 1 - opponentShotCount;
+}
+
+  // Place the fleet where the opponent's early shots have been rarest,
+  // leaving b empty if no layout is found.
+bool GoodPlayer::placeAwayFromShots(Board& b)
+{
+    Bitboard free;
+    b.freeCells(free);
+    pmr::vector<int> lengths(gameMemory());
+    for ( int i = 0; i < game().nShips(); i++)
+        lengths.push_back(game().shipLength(i));
+    pmr::vector<ShipPlacement> layout(gameMemory());
+    if ( !layoutSearch.search(free, lengths, opponentShots, layoutsPerGame, layoutMs,
+                              ThreadPool::shared(), layout) )
+        return false;
+    for ( int i = 0; i < layout.size(); i++)
     {
-        if ( shotHit )
+        if ( !b.placeShip(layout[i].topOrLeft, i, layout[i].dir) )
         {
-            if ( dir == VERTICAL && p.r > botOrRight.r )
-                botOrRight = p;
-            else if ( dir == VERTICAL && p.r < topOrLeft.r )
-            {
-                topOrLeft = p;
-            }
-            else if ( dir == HORIZONTAL && p.c > botOrRight.c )
-                botOrRight = p;
-            else if ( dir == HORIZONTAL && p.c < topOrLeft.c )
-            {
-                topOrLeft = p;
-            }
-        }
-        
-        if ( shipDestroyed )
-        {
-            shipLengths.erase(find(shipLengths.begin(), shipLengths.end(), game().shipLength(shipId)));
-            if ( ((dir == VERTICAL )&&  ((botOrRight.r - topOrLeft.r + 1) == game().shipLength(shipId) ))|| ( dir == HORIZONTAL && (botOrRight.c - topOrLeft.c + 1 == game().shipLength(shipId)) ))  ////   check if shipLength
-            {
-                if ( collateral )
-                {
-                    currentState = 2;
-                    transitionPt = ptsToExplore.front();
-                }
-                else
-                {
-                    currentState = 1;
-                    while ( !ptsToExplore.empty() ) ptsToExplore.pop();
-                }
-                return;
-            }
-            else
-            {
-                currentState = 2;
-            }
-        }
-        else if ( shotHit )
-        {
-            ptsToExplore.push(p);
-            return;
-        }
-        else
-        {
-            return;
+            b.clear();
+            return false;
         }
     }
-    
-    
-}
-void GoodPlayer::recordAttackByOpponent(Point p)
-{
-    ///////////not used
-    
-    
+    return true;
 }
 
 
 int GoodPlayer::calcProb(const Point& p, const int& biggestShipLeft ) const
 {
+    if ( !game().isValid(p) )
+        return -4;
     
-    int Xleft = 0;
-    int Xright = 0;
-    int Ydown = 0;
-    int Yup = 0;
-    for ( int x = 1; x + p.c < game().cols()  ; x++)
-    {
-        if ( oppGrid[p.r][x+p.c] == '.' )
-            Xright++;
-        else
-            break;
-    }
-    for ( int x = 1; p.c - x >= 0 ; x++)
-    {
-        if ( oppGrid[p.r][p.c-x] == '.')
-            Xleft++;
-        else
-            break;
-    }
-    for ( int y = 1; y + p.r < game().rows()  ; y++)
-    {
-        if ( oppGrid[p.r+y][p.c] == '.' )
-            Ydown++;
-        else
-            break;
-        
-    }
-    for ( int y = 1; p.r - y >= 0 ; y++)
-    {
-        if ( oppGrid[p.r-y][p.c] == '.')
-            Yup++;
-        else
-            break;
-    }
+    const Runs& run = runs[p.r * game().cols() + p.c];
+    int Xleft = run.left;
+    int Xright = run.right;
+    int Ydown = run.down;
+    int Yup = run.up;
     
     if ( 1 + Yup + Ydown < biggestShipLeft && 1 + Xleft + Xright < biggestShipLeft )
         return -3;
@@ -822,46 +835,154 @@ int GoodPlayer::calcProb(const Point& p, const int& biggestShipLeft ) const
     return (Xleft+Xright+Yup+Ydown);
 }
 
+  // A cell's calcProb depends only on the '.' runs in its own row and
+  // column, so a shot at p changes the runs, and the heat, of just the '.'
+  // cells whose runs reached p.  The shot cell leaves the heap and those
+  // cells are rescored in place, so the best cell is always on top.
+  // Everything is recomputed only when the biggest ship left changes.
 
-Point GoodPlayer::bestMove()
+void GoodPlayer::rebuildHeat()
 {
-    vector<int> probables;
-    int maxIndex = 0;
-    
-    for ( int i = 0; i < openPoints.size(); i++)
+    heatBiggest = shipLengths.back();
+    heat.clear(game().rows() * game().cols());
+    for ( int r = 0; r < game().rows(); r++)
+        for ( int c = 0; c < game().cols(); c++)
+        {
+            if ( oppAt(r, c) == '.' )
+                heat.set(r * game().cols() + c, calcProb(Point(r,c), heatBiggest));
+        }
+}
+
+  // Cut the runs of the '.' cells from p in direction (dr, dc) short at p
+void GoodPlayer::updateHeatLine(const Point& p, int dr, int dc)
+{
+    int gap = 0;    // '.' cells between p and q
+    for ( Point q(p.r + dr, p.c + dc); game().isValid(q) && oppAt(q.r, q.c) == '.'; q.r += dr, q.c += dc, gap++)
     {
-        probables.push_back( calcProb(openPoints.at(i), shipLengths.back()) );
-        if ( probables[i] > probables[maxIndex])
-            maxIndex = i;
+        int cell = q.r * game().cols() + q.c;
+        if ( dc != 0 )
+            (dc < 0 ? runs[cell].right : runs[cell].left) = gap;
+        else
+            (dr < 0 ? runs[cell].down : runs[cell].up) = gap;
+        if ( heatBiggest != 0 )   // built already
+            heat.set(cell, calcProb(q, heatBiggest));
     }
-    
-    Point attackPt = openPoints.at(maxIndex);
-    openPoints.erase(openPoints.begin() + maxIndex);
-    
-    return attackPt;
-    
+}
+
+void GoodPlayer::updateHeatAround(const Point& p)
+{
+    updateHeatLine(p, 0, -1);
+    updateHeatLine(p, 0, 1);
+    updateHeatLine(p, -1, 0);
+    updateHeatLine(p, 1, 0);
+}
+
+Point GoodPlayer::bestMove()
+{
+    if ( shipLengths.empty() )
+        return game().randomPoint();
+    if ( heatBiggest != shipLengths.back() )
+        rebuildHeat();
+    if ( heat.empty() )
+        return game().randomPoint();
+    int cell = heat.top();
+    return Point(cell / game().cols(), cell % game().cols());
+}
+
+Point GoodPlayer::densityMove()
+{
+    if ( !densityCurrent )
+    {
+        density.compute(oppGrid, shipLengths);
+        densityCurrent = true;
+    }
+    const PlacementPrior* prior = nullptr;
+    if ( huntingByPrior() )
+        prior = &opponentPrior;
+    int cell = density.bestCell(oppGrid, prior);
+    if ( cell == -1 )
+        return game().randomPoint();
+    return Point(cell / game().cols(), cell % game().cols());
+}
+
+Point GoodPlayer::monteCarloMove()
+{
+      // Hits left over from sunk ships that couldn't be pinned down can make
+      // every draw fail; the density map copes with those.
+    if ( sampler.sample(oppGrid, shipLengths, samplesPerTurn, msPerTurn, ThreadPool::shared()) == 0 )
+        return densityMove();
+    int cell = sampler.bestCell(oppGrid);
+    if ( cell == -1 )
+        return game().randomPoint();
+    return Point(cell / game().cols(), cell % game().cols());
 }
 
 //*********************************************************************
 //  createPlayer
 //*********************************************************************
 
+  // Indexed as in createPlayer's switch
+static const char* const playerTypes[] = {
+    "human", "awful", "mediocre", "good", "density", "montecarlo", "adaptive", "adaptive-place"
+};
+
+vector<string> computerPlayerTypes()
+{
+    vector<string> types;
+    for ( int i = 1; i < sizeof(playerTypes)/sizeof(playerTypes[0]); i++)
+        types.push_back(playerTypes[i]);
+    return types;
+}
+
+static bool densityFits(string type, const Game& g)
+{
+    if ( g.rows() * g.cols() <= MAX_DENSITY_CELLS )
+        return true;
+    cout << "Player type " << type << " plays boards of at most " << MAX_DENSITY_CELLS << " cells" << endl;
+    return false;
+}
+
 Player* createPlayer(string type, string nm, const Game& g)
 {
-    static string types[] = {
-        "human", "awful", "mediocre", "good"
-    };
+      // "montecarlo" may be followed by ":<samples>" or ":<ms>ms" per turn
+    if ( type.compare(0, 11, "montecarlo:") == 0 )
+    {
+        string setting = type.substr(11);
+        int n = atoi(setting.c_str());
+        if ( n < 1 || !densityFits(type, g) )
+            return nullptr;
+        if ( setting.size() > 2 && setting.compare(setting.size() - 2, 2, "ms") == 0 )
+            return new GoodPlayer(nm, g, GoodPlayer::MONTE_CARLO, 0, n);
+        return new GoodPlayer(nm, g, GoodPlayer::MONTE_CARLO, n, 0);
+    }
+      // and "adaptive-place" by ":<layouts>" or ":<ms>ms" per placement
+    if ( type.compare(0, 15, "adaptive-place:") == 0 )
+    {
+        string setting = type.substr(15);
+        int n = atoi(setting.c_str());
+        if ( n < 1 || !densityFits(type, g) )
+            return nullptr;
+        if ( setting.size() > 2 && setting.compare(setting.size() - 2, 2, "ms") == 0 )
+            return new GoodPlayer(nm, g, GoodPlayer::DENSITY, 0, 0, false, true, 0, n);
+        return new GoodPlayer(nm, g, GoodPlayer::DENSITY, 0, 0, false, true, n, 0);
+    }
     
     int pos;
-    for (pos = 0; pos != sizeof(types)/sizeof(types[0])  &&
-         type != types[pos]; pos++)
+    for (pos = 0; pos != sizeof(playerTypes)/sizeof(playerTypes[0])  &&
+         type != playerTypes[pos]; pos++)
         ;
+    if ( pos >= 4 && pos <= 7 && !densityFits(type, g) )   // the density-based types
+        return nullptr;
     switch (pos)
     {
         case 0:  return new HumanPlayer(nm, g);
         case 1:  return new AwfulPlayer(nm, g);
         case 2:  return new MediocrePlayer(nm, g);
         case 3:  return new GoodPlayer(nm, g);
+        case 4:  return new GoodPlayer(nm, g, GoodPlayer::DENSITY);
+        case 5:  return new GoodPlayer(nm, g, GoodPlayer::MONTE_CARLO);
+        case 6:  return new GoodPlayer(nm, g, GoodPlayer::DENSITY, 0, 0, true);
+        case 7:  return new GoodPlayer(nm, g, GoodPlayer::DENSITY, 0, 0, false, true);
         default: return nullptr;
     }
 }
@@ -1,13 +1,17 @@
 #ifndef PLAYER_INCLUDED
 #define PLAYER_INCLUDED
 
+#include "Arena.h"
 #include <string>
+#include <vector>
 
 class Point;
 class Board;
 class Game;
 
-class Player
+  // Players are ArenaObjects, so those made inside an ArenaScope live in
+  // the game's arena, as does everything they allocate.
+class Player : public ArenaObject
 {
   public:
     Player(std::string nm, const Game& g)
@@ -20,12 +24,18 @@ class Player
     const Game& game() const { return m_game; }
 
     virtual bool isHuman() const { return false; }
+      // Whether what the player learns in one game carries over to the
+      // next, so that a game depends on those played before it
+    virtual bool learnsAcrossGames() const { return false; }
 
     virtual bool placeShips(Board& b) = 0;
     virtual Point recommendAttack() = 0;
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
                                         bool shipDestroyed, int shipId) = 0;
     virtual void recordAttackByOpponent(Point p) = 0;
+      // Forget everything learned in the game played so far, so the player
+      // can play another game as if it had just been created.
+    virtual void reset() = 0;
       // We prevent any kind of Player object from being copied or assigned
     Player(const Player&) = delete;
     Player& operator=(const Player&) = delete;
@@ -35,6 +45,25 @@ class Player
     const Game& m_game;
 };
 
+  // The density-based types ("density", "montecarlo", "adaptive" and
+  // "adaptive-place") still look at every cell every turn, so createPlayer
+  // refuses them on boards of more than this many cells, where a game would
+  // take minutes.
+const int MAX_DENSITY_CELLS = 65536;
+
 Player* createPlayer(std::string type, std::string nm, const Game& g);
 
+  // The types createPlayer accepts that make computer players (every type
+  // but "human"), weakest first.  "good" hunts by a heat map and follows
+  // up hits cluster by cluster (HitTracker.h); "density" counts the
+  // placements covering each cell (DensityMap.h); "montecarlo" shoots where
+  // most sampled fleets overlap (PlacementSampler.h); "adaptive" weighs its
+  // hunt by where the opponent's ships were in earlier games
+  // (PlacementPrior.h); "adaptive-place" places its fleet away from where
+  // the opponent has shot before (LayoutSearch.h).  All but "awful" and
+  // "mediocre" play the last few shots exactly (EndgameSolver.h).
+  // "montecarlo:N" and "adaptive-place:N" set the samples per turn or
+  // layouts per game, and ":Nms" a time budget instead.
+std::vector<std::string> computerPlayerTypes();
+
 #endif // PLAYER_INCLUDED
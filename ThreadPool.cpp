@@ -0,0 +1,114 @@
+#include "ThreadPool.h"
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+using namespace std;
+
+struct ThreadPool::Loop
+{
+    const function<void(int)>* task;
+    int nTasks;
+    atomic<int> next;       // index of the next task to claim
+    int helpers;            // workers still inside runTasks for this loop
+};
+
+ThreadPool::ThreadPool(int nThreads)
+ : m_closing(false)
+{
+    for ( int i = 0; i < nThreads; i++)
+        m_workers.push_back(thread(&ThreadPool::workerMain, this));
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_closing = true;
+    }
+    m_wake.notify_all();
+    for ( int i = 0; i < m_workers.size(); i++)
+        m_workers[i].join();
+}
+
+ThreadPool& ThreadPool::shared()
+{
+    static ThreadPool pool(thread::hardware_concurrency() > 1 ? thread::hardware_concurrency() - 1 : 0);
+    return pool;
+}
+
+void ThreadPool::runTasks(Loop& loop)
+{
+    for ( int i = loop.next++; i < loop.nTasks; i = loop.next++)
+        (*loop.task)(i);
+}
+
+void ThreadPool::workerMain()
+{
+    unique_lock<mutex> lock(m_mutex);
+    for (;;)
+    {
+        m_wake.wait(lock, [this] { return m_closing || !m_queue.empty(); });
+        if ( m_queue.empty() )
+            return;
+        Loop* loop = m_queue.front();
+        m_queue.erase(m_queue.begin());
+        loop->helpers++;
+        lock.unlock();
+        runTasks(*loop);
+        lock.lock();
+        loop->helpers--;
+        m_done.notify_all();
+    }
+}
+
+void ThreadPool::parallelFor(int nTasks, const function<void(int)>& task)
+{
+    Loop loop;
+    loop.task = &task;
+    loop.nTasks = nTasks;
+    loop.next = 0;
+    loop.helpers = 0;
+
+    int invited = min(nTasks - 1, size());
+    if ( invited > 0 )
+    {
+        lock_guard<mutex> lock(m_mutex);
+        for ( int i = 0; i < invited; i++)
+            m_queue.push_back(&loop);
+    }
+    if ( invited > 0 )
+        m_wake.notify_all();
+
+    runTasks(loop);
+
+      // Withdraw invitations nobody took up, then wait for the helpers that
+      // did, since they still refer to loop.
+    unique_lock<mutex> lock(m_mutex);
+    m_queue.erase(remove(m_queue.begin(), m_queue.end(), &loop), m_queue.end());
+    m_done.wait(lock, [&loop] { return loop.helpers == 0; });
+}
+
+void ThreadPool::parallelForBudget(int nTasks, int count, int budgetMs, const function<void(int)>& step)
+{
+    struct Budget
+    {
+        int nTasks;
+        int count;
+        int budgetMs;
+        chrono::steady_clock::time_point deadline;
+        const function<void(int)>* step;
+    } budget { nTasks, count, budgetMs, chrono::steady_clock::now() + chrono::milliseconds(budgetMs), &step };
+
+      // Capture one pointer, so the std::function holding this needn't
+      // allocate.
+    parallelFor(nTasks, [&budget](int t) {
+        int calls = (budget.budgetMs > 0 ? INT_MAX : (budget.count + budget.nTasks - 1 - t) / budget.nTasks);
+        for ( int i = 0; i < calls; i++)
+        {
+            if ( budget.budgetMs > 0 && i % 16 == 0 && chrono::steady_clock::now() >= budget.deadline )
+                break;
+            (*budget.step)(t);
+        }
+    });
+}
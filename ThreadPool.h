@@ -0,0 +1,57 @@
+#ifndef THREADPOOL_INCLUDED
+#define THREADPOOL_INCLUDED
+
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+  // A fixed set of worker threads that run index-parallel loops.  The thread
+  // calling parallelFor works on its own loop too, so loops can be started
+  // from several threads at once (tournament workers, say) without any of
+  // them waiting on a pool that is busy with someone else's loop.
+class ThreadPool
+{
+  public:
+    explicit ThreadPool(int nThreads);
+    ~ThreadPool();
+    int size() const { return m_workers.size(); }
+
+      // Run task(0) ... task(nTasks-1) and return once all have finished.
+    void parallelFor(int nTasks, const std::function<void(int)>& task);
+
+      // How many tasks a budgeted loop should be split into.  Fixed so that
+      // the split of work, and so the result, doesn't depend on how many
+      // threads the pool has.
+    static const int BUDGET_TASKS = 16;
+
+      // Run nTasks tasks, task t calling step(t) over and over: count calls
+      // in all, split as evenly as possible, or if budgetMs is positive, as
+      // many as each task fits in budgetMs milliseconds.
+    void parallelForBudget(int nTasks, int count, int budgetMs, const std::function<void(int)>& step);
+
+      // One pool per process, with a worker for each hardware thread after
+      // the first.
+    static ThreadPool& shared();
+
+      // We prevent a ThreadPool object from being copied or assigned
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+  private:
+    struct Loop;
+
+    std::vector<std::thread> m_workers;
+    std::vector<Loop*> m_queue;         // one entry per worker invited to help a loop; a
+                                        // vector, so queueing never allocates once it has grown
+    std::mutex m_mutex;
+    std::condition_variable m_wake;     // work was queued, or the pool is closing
+    std::condition_variable m_done;     // a helper left a loop
+    bool m_closing;
+
+    void workerMain();
+    static void runTasks(Loop& loop);
+};
+
+#endif // THREADPOOL_INCLUDED
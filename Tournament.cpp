@@ -0,0 +1,528 @@
+#include "Tournament.h"
+#include "Game.h"
+#include "Player.h"
+#include "GameObserver.h"
+#include "GameLog.h"
+#include "Arena.h"
+#include "Match.h"
+#include "BatchEngine.h"
+#include "FixedBoard.h"
+#include "globals.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdlib>
+#include <cctype>
+#include <cstdio>
+#include <memory_resource>
+#include <algorithm>
+
+using namespace std;
+
+  // Most games a worker claims at a time.  Big enough that the shared
+  // counter is rarely touched, and cut down for short runs so that every
+  // thread still gets many claims and they all finish together.
+const long long MAX_GAMES_PER_CLAIM = 64;
+
+bool parseFleet(const string& text, vector<ShipSpec>& fleet)
+{
+    fleet.clear();
+    if ( text == "standard" )
+    {
+        for ( int i = 0; i < STANDARD_FLEET_SIZE; i++)
+            fleet.push_back(ShipSpec { STANDARD_FLEET[i].length, STANDARD_FLEET[i].symbol, STANDARD_FLEET[i].name });
+        return true;
+    }
+
+    size_t start = 0;
+    while ( start < text.size() )
+    {
+        size_t end = text.find(',', start);
+        if ( end == string::npos )
+            end = text.size();
+        string item = text.substr(start, end - start);   // e.g. "5A"
+        size_t digits = 0;
+        while ( digits < item.size() && isdigit(item[digits]) )
+            digits++;
+        if ( digits == 0 || digits + 1 != item.size() )
+            return false;
+        int length = atoi(item.substr(0, digits).c_str());
+        char symbol = item[digits];
+        fleet.push_back(ShipSpec { length, symbol, string("ship ") + symbol });
+        start = end + 1;
+    }
+    return !fleet.empty();
+}
+
+bool addFleet(Game& g, const vector<ShipSpec>& fleet)
+{
+    for ( int i = 0; i < fleet.size(); i++)
+    {
+        if ( !g.addShip(fleet[i].length, fleet[i].symbol, fleet[i].name) )
+            return false;
+    }
+    return true;
+}
+
+bool parseTournamentArgs(int argc, char* argv[], TournamentSpec& spec)
+{
+    if ( argc < 4 )
+    {
+        cout << "Usage: " << argv[0] << " tournament <type1> <type2> [--games N] [--threads N]"
+             << " [--rows R] [--cols C] [--fleet standard|5A,4B,...] [--seed S] [--log path] [--latency]"
+             << " [--batch K]" << endl;
+        cout << "       " << argv[0] << " replay <type1> <type2> --seed S --game K"
+             << " [--rows R] [--cols C] [--fleet ...]" << endl;
+        return false;
+    }
+    bool replay = string(argv[1]) == "replay";
+    spec.type1 = argv[2];
+    spec.type2 = argv[3];
+    spec.nGames = 500;
+    spec.firstGame = 1;
+    spec.nThreads = thread::hardware_concurrency();
+    if ( spec.nThreads < 1 )
+        spec.nThreads = 1;
+    spec.rows = STANDARD_ROWS;
+    spec.cols = STANDARD_COLS;
+    parseFleet("standard", spec.fleet);
+    spec.seed = random_device{}();
+    spec.seed = (spec.seed << 32) | random_device{}();
+    spec.replayGame = 0;
+    bool seedGiven = false;
+
+    spec.timeCalls = false;
+    spec.batchSlots = 0;
+    for ( int i = 4; i < argc; i += 2)
+    {
+        string option = argv[i];
+        if ( option == "--latency" )
+        {
+            spec.timeCalls = true;
+            i--;            // takes no value
+            continue;
+        }
+        if ( i + 1 >= argc )
+        {
+            cout << "Option " << option << " needs a value" << endl;
+            return false;
+        }
+        string value = argv[i+1];
+        if ( option == "--games" )
+            spec.nGames = atoll(value.c_str());
+        else if ( option == "--threads" )
+            spec.nThreads = atoi(value.c_str());
+        else if ( option == "--rows" )
+            spec.rows = atoi(value.c_str());
+        else if ( option == "--cols" )
+            spec.cols = atoi(value.c_str());
+        else if ( option == "--seed" )
+        {
+            spec.seed = strtoull(value.c_str(), nullptr, 10);
+            seedGiven = true;
+        }
+        else if ( option == "--log" )
+            spec.logPath = value;
+        else if ( option == "--batch" )
+            spec.batchSlots = atoi(value.c_str());
+        else if ( option == "--game" )
+            spec.replayGame = atoll(value.c_str());
+        else if ( option == "--fleet" )
+        {
+            if ( !parseFleet(value, spec.fleet) )
+            {
+                cout << "Bad fleet " << value << "; expected standard or a list like 5A,4B,3D" << endl;
+                return false;
+            }
+        }
+        else
+        {
+            cout << "Unknown option " << option << endl;
+            return false;
+        }
+    }
+
+    if ( spec.nGames < 1 || spec.nThreads < 1 || spec.batchSlots < 0 )
+    {
+        cout << "The game and thread counts must be positive" << endl;
+        return false;
+    }
+    if ( spec.batchSlots > 0 && (replay || spec.timeCalls || !spec.logPath.empty()) )
+    {
+        cout << "Batched games can't be replayed, timed or logged" << endl;
+        return false;
+    }
+    if ( replay && (!seedGiven || spec.replayGame < 1) )
+    {
+        cout << "A replay needs the tournament's --seed and a --game of 1 or more" << endl;
+        return false;
+    }
+
+      // Let Game and createPlayer report any problem with the spec once,
+      // before the workers start and output is switched off.
+    Game g(spec.rows, spec.cols);
+    if ( !addFleet(g, spec.fleet) )
+        return false;
+    string types[2] = { spec.type1, spec.type2 };
+    for ( int i = 0; i < 2; i++)
+    {
+        if ( spec.batchSlots > 0 )
+        {
+            BatchAttacker* a = createBatchAttacker(types[i], g, spec.batchSlots);
+            if ( a == nullptr )
+            {
+                cout << "Player type " << types[i] << " can't be batched on a "
+                     << spec.rows << "x" << spec.cols << " board" << endl;
+                return false;
+            }
+            delete a;
+            continue;
+        }
+        Player* p = createPlayer(types[i], types[i], g);
+        if ( p == nullptr || p->isHuman() )
+        {
+            cout << "Player type " << types[i] << " can't be used in a tournament" << endl;
+            delete p;
+            return false;
+        }
+        delete p;
+    }
+    return true;
+}
+
+  // The game and the two players every game of a tournament is played
+  // with; the Match resets them between games.  Constructing players uses
+  // no random numbers, so unless a player learns across games, game k plays
+  // the same however many games the match played before it.
+class TournamentTable
+{
+  public:
+    TournamentTable(const TournamentSpec& spec);
+    ~TournamentTable();
+      // Play game k.  Returns 1 or 2 for the type that won, 0 if there was
+      // no winner.
+    int playGame(long long k, GameObserver& observer);
+      // Whether a player carries what it learns from game to game
+    bool learns() const { return m_p1->learnsAcrossGames() || m_p2->learnsAcrossGames(); }
+    const Player* player1() const { return m_p1; }
+    const Player* player2() const { return m_p2; }
+
+  private:
+    const TournamentSpec& m_spec;
+    Game m_game;
+    Player* m_p1;
+    Player* m_p2;
+    Match* m_match;
+};
+
+TournamentTable::TournamentTable(const TournamentSpec& spec)
+ : m_spec(spec), m_game(spec.rows, spec.cols)
+{
+    addFleet(m_game, spec.fleet);
+    m_p1 = createPlayer(spec.type1, spec.type1 + " 1", m_game);
+    m_p2 = createPlayer(spec.type2, spec.type2 + " 2", m_game);
+    m_match = new Match(m_game, m_p1, m_p2);
+}
+
+TournamentTable::~TournamentTable()
+{
+    delete m_match;
+    delete m_p1;
+    delete m_p2;
+}
+
+int TournamentTable::playGame(long long k, GameObserver& observer)
+{
+    seedRandom(m_spec.seed, k);
+    Player* winner = m_match->play(k % 2 == 1, observer);
+    if ( winner == m_p1 )
+        return 1;
+    if ( winner == m_p2 )
+        return 2;
+    return 0;
+}
+
+  // Hands out the games of a run to its workers a claim at a time, in
+  // chunks: no game of a chunk is handed out until every game of the one
+  // before has been played and goOn has said to carry on.  Workers report
+  // each claim's results as they finish it.
+class GameQueue
+{
+  public:
+    GameQueue(const TournamentSpec& spec, long long chunkGames,
+              const function<bool(const TournamentResult&)>& goOn, TournamentResult& totals);
+      // Claim up to n games, first to last; false once there are none left
+    bool claim(long long n, long long& first, long long& last);
+      // nGames claimed games have been played, with these results
+    void finished(long long nGames, long long wins1, long long wins2, long long noResult);
+
+  private:
+    const function<bool(const TournamentResult&)>& m_goOn;
+    TournamentResult& m_totals;
+    long long m_chunkGames;
+    long long m_lastGame;
+    long long m_next;           // the next game to hand out
+    long long m_chunkEnd;       // the last game of the chunk being handed out
+    long long m_unfinished;     // games of that chunk not played yet
+    bool m_stopped;
+    mutex m_mutex;
+    condition_variable m_nextChunk;
+};
+
+GameQueue::GameQueue(const TournamentSpec& spec, long long chunkGames,
+                     const function<bool(const TournamentResult&)>& goOn, TournamentResult& totals)
+ : m_goOn(goOn), m_totals(totals), m_lastGame(spec.firstGame + spec.nGames - 1),
+   m_next(spec.firstGame), m_stopped(false)
+{
+    m_chunkGames = (chunkGames > 0 ? chunkGames : spec.nGames);
+    m_chunkEnd = min(m_next + m_chunkGames - 1, m_lastGame);
+    m_unfinished = m_chunkEnd - m_next + 1;
+}
+
+bool GameQueue::claim(long long n, long long& first, long long& last)
+{
+    unique_lock<mutex> lock(m_mutex);
+    m_nextChunk.wait(lock, [this] { return m_stopped || m_next > m_lastGame || m_next <= m_chunkEnd; });
+    if ( m_stopped || m_next > m_lastGame )
+        return false;
+    first = m_next;
+    last = min(first + n - 1, m_chunkEnd);
+    m_next = last + 1;
+    return true;
+}
+
+void GameQueue::finished(long long nGames, long long wins1, long long wins2, long long noResult)
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_totals.wins1 += wins1;
+    m_totals.wins2 += wins2;
+    m_totals.noResult += noResult;
+    m_unfinished -= nGames;
+    if ( m_unfinished > 0 || m_stopped )
+        return;
+    if ( (m_goOn && !m_goOn(m_totals)) || m_chunkEnd == m_lastGame )
+        m_stopped = true;
+    else
+    {
+        m_chunkEnd = min(m_chunkEnd + m_chunkGames, m_lastGame);
+        m_unfinished = m_chunkEnd - m_next + 1;
+    }
+    m_nextChunk.notify_all();
+}
+
+long long claimSize(const TournamentSpec& spec)
+{
+    long long gamesPerClaim = spec.nGames / (16LL * spec.nThreads);
+    if ( gamesPerClaim > MAX_GAMES_PER_CLAIM )
+        gamesPerClaim = MAX_GAMES_PER_CLAIM;
+    if ( gamesPerClaim < 1 )
+        gamesPerClaim = 1;
+    return gamesPerClaim;
+}
+
+void playTournamentGames(const TournamentSpec& spec, int worker, GameQueue& queue,
+                         TournamentResult& totals, mutex& totalsMutex)
+{
+    CountingGameObserver counts;
+    LatencyGameObserver* latency = nullptr;
+
+      // The table lasts the whole run, so it lives in a pool that recycles
+      // what the players free between games; everything else a game
+      // allocates comes from arena, which is wiped in one step afterwards.
+    pmr::unsynchronized_pool_resource tableMemory;
+    ArenaScope tableScope(tableMemory);
+    TournamentTable table(spec);
+    Arena arena;
+    NullGameObserver noLog;
+    GameLogWriter* log = nullptr;
+    if ( !spec.logPath.empty() )
+        log = new GameLogWriter(spec.logPath + "." + to_string(worker));
+    if ( spec.timeCalls )
+    {
+        latency = new LatencyGameObserver;
+        latency->setPlayers(table.player1(), table.player2());
+    }
+    TeeGameObserver extras(log != nullptr ? *log : static_cast<GameObserver&>(noLog),
+                           latency != nullptr ? *latency : static_cast<GameObserver&>(noLog));
+    TeeGameObserver observer(counts, extras);
+    long long gamesPerClaim = claimSize(spec);
+
+    long long first;
+    long long last;
+    while ( queue.claim(gamesPerClaim, first, last) )
+    {
+        long long myWins1 = 0;
+        long long myWins2 = 0;
+        long long myNoResult = 0;
+        for ( long long k = first; k <= last; k++)
+        {
+            int winner;
+            {
+                ArenaScope scope(arena);
+                winner = table.playGame(k, observer);
+            }
+            arena.reset();
+            if ( winner == 1 )
+                myWins1++;
+            else if ( winner == 2 )
+                myWins2++;
+            else
+                myNoResult++;
+        }
+        queue.finished(last - first + 1, myWins1, myWins2, myNoResult);
+    }
+
+    delete log;
+    lock_guard<mutex> lock(totalsMutex);
+    totals.counts.add(counts);
+    if ( latency != nullptr )
+        totals.latency.add(*latency);
+    delete latency;
+}
+
+  // playTournamentGames for the batch engine
+void playBatchedTournamentGames(const TournamentSpec& spec, int worker, GameQueue& queue,
+                                TournamentResult& totals, mutex& totalsMutex)
+{
+    pmr::unsynchronized_pool_resource memory;
+    ArenaScope scope(memory);
+    Game g(spec.rows, spec.cols);
+    addFleet(g, spec.fleet);
+    long long gamesPerClaim = claimSize(spec);
+    long long next = 0;
+    long long last = -1;
+    long long claimed = 0;
+    auto claim = [&](long long& k) {
+        if ( next > last )
+        {
+            if ( !queue.claim(gamesPerClaim, next, last) )
+                return false;
+            claimed += last - next + 1;
+        }
+        k = next++;
+        return true;
+    };
+
+    long long myWins1 = 0;
+    long long myWins2 = 0;
+    long long myNoResult = 0;
+    CountingGameObserver counts;
+    playBatchedGames(g, spec.type1, spec.type2, spec.batchSlots, spec.seed, claim,
+                     myWins1, myWins2, myNoResult, counts);
+    queue.finished(claimed, myWins1, myWins2, myNoResult);
+
+    lock_guard<mutex> lock(totalsMutex);
+    totals.counts.add(counts);
+}
+
+TournamentResult runTournament(const TournamentSpec& spec, long long chunkGames,
+                               const function<bool(const TournamentResult&)>& goOn)
+{
+    TournamentResult result;
+    result.wins1 = 0;
+    result.wins2 = 0;
+    result.noResult = 0;
+    mutex resultMutex;
+      // A batched worker holds games in many slots at once, so it can't
+      // wait for a chunk to finish; its run is one chunk.
+    GameQueue queue(spec, spec.batchSlots > 0 ? 0 : chunkGames, goOn, result);
+
+    auto start = chrono::steady_clock::now();
+
+    vector<thread> workers;
+    for ( int i = 0; i < spec.nThreads; i++)
+        workers.push_back(thread(spec.batchSlots > 0 ? playBatchedTournamentGames : playTournamentGames,
+                                 cref(spec), i, ref(queue), ref(result), ref(resultMutex)));
+    for ( int i = 0; i < workers.size(); i++)
+        workers[i].join();
+
+    auto stop = chrono::steady_clock::now();
+
+    result.seconds = chrono::duration<double>(stop - start).count();
+    return result;
+}
+
+  // A duration to three or so significant figures in a sensible unit
+string formatNanoseconds(uint64_t ns)
+{
+    char buffer[32];
+    if ( ns < 1000 )
+        snprintf(buffer, sizeof(buffer), "%llu ns", (unsigned long long) ns);
+    else if ( ns < 1000000 )
+        snprintf(buffer, sizeof(buffer), "%.3g us", ns / 1e3);
+    else if ( ns < 1000000000 )
+        snprintf(buffer, sizeof(buffer), "%.3g ms", ns / 1e6);
+    else
+        snprintf(buffer, sizeof(buffer), "%.3g s", ns / 1e9);
+    return buffer;
+}
+
+void reportLatency(const TournamentSpec& spec, const LatencyGameObserver& latency)
+{
+    static const char* const callNames[N_PLAYER_CALLS] = {
+        "placeShips", "recommendAttack", "recordAttackResult"
+    };
+    string types[2] = { spec.type1, spec.type2 };
+    cout << "  Call latency (p50 / p99 / p99.9 / max):" << endl;
+    for ( int p = 0; p < 2; p++)
+    {
+        for ( int c = 0; c < N_PLAYER_CALLS; c++)
+        {
+            const LatencyHistogram& h = latency.histogram(p, PlayerCall(c));
+            if ( h.count() == 0 )
+                continue;
+            cout << "    " << types[p] << " " << callNames[c] << ": "
+                 << formatNanoseconds(h.percentile(50)) << " / "
+                 << formatNanoseconds(h.percentile(99)) << " / "
+                 << formatNanoseconds(h.percentile(99.9)) << " / "
+                 << formatNanoseconds(h.max()) << " over " << h.count() << " calls" << endl;
+        }
+    }
+}
+
+void reportTournament(const TournamentSpec& spec, const TournamentResult& result)
+{
+    cout << spec.nGames << " games of " << spec.type1 << " vs " << spec.type2
+         << " on " << spec.rows << "x" << spec.cols << " with " << spec.fleet.size()
+         << " ships, " << spec.nThreads << " threads, seed " << spec.seed;
+    if ( spec.batchSlots > 0 )
+        cout << ", batches of " << spec.batchSlots;
+    cout << endl;
+    cout << "  " << spec.type1 << " won " << result.wins1 << " ("
+         << 100.0 * result.wins1 / spec.nGames << "%)" << endl;
+    cout << "  " << spec.type2 << " won " << result.wins2 << " ("
+         << 100.0 * result.wins2 / spec.nGames << "%)" << endl;
+    if ( result.noResult != 0 )
+        cout << "  " << result.noResult << " games had no winner (ships could not be placed)" << endl;
+    if ( result.counts.games != 0 )
+        cout << "  " << double(result.counts.turns) / result.counts.games << " turns, "
+             << double(result.counts.hits) / result.counts.games << " hits and "
+             << double(result.counts.wastedShots) / result.counts.games
+             << " wasted shots per game" << endl;
+    cout << "  " << result.seconds << " s, "
+         << (result.seconds > 0 ? spec.nGames / result.seconds : 0) << " games/sec" << endl;
+    if ( spec.timeCalls )
+        reportLatency(spec, result.latency);
+}
+
+void replayTournamentGame(const TournamentSpec& spec)
+{
+    cout << "Replaying game " << spec.replayGame << " of seed " << spec.seed << endl;
+    ConsoleGameObserver console;
+    TournamentTable table(spec);
+    if ( table.learns() )
+    {
+          // Bring the learning player to where a one-thread tournament's
+          // would be by game replayGame
+        cout << "(after playing games " << spec.firstGame << " to " << spec.replayGame - 1
+             << " as a --threads 1 tournament would)" << endl;
+        NullGameObserver quiet;
+        for ( long long k = spec.firstGame; k < spec.replayGame; k++)
+            table.playGame(k, quiet);
+    }
+    table.playGame(spec.replayGame, console);
+}
@@ -0,0 +1,78 @@
+#ifndef TOURNAMENT_INCLUDED
+#define TOURNAMENT_INCLUDED
+
+#include <string>
+#include <vector>
+#include <functional>
+#include "GameObserver.h"
+
+class Game;
+
+struct ShipSpec
+{
+    int length;
+    char symbol;
+    std::string name;
+};
+
+struct TournamentSpec
+{
+    std::string type1;          // player types as accepted by createPlayer
+    std::string type2;
+    long long nGames;
+    long long firstGame;        // the games played are firstGame .. firstGame+nGames-1
+    int nThreads;
+    int rows;
+    int cols;
+    std::vector<ShipSpec> fleet;
+    unsigned long long seed;    // game k is played from seedRandom(seed, k)
+    long long replayGame;       // for replay: the k of the game to replay
+    std::string logPath;        // if set, worker thread i logs its games to logPath.i
+    bool timeCalls;             // keep latency histograms of every player call
+    int batchSlots;             // if positive, play on the batch engine, this many games at a time per thread
+};
+
+struct TournamentResult
+{
+    long long wins1;            // games won by type1, whichever seat it had
+    long long wins2;
+    long long noResult;         // games where Game::play returned nullptr
+    CountingGameObserver counts;
+    LatencyGameObserver latency;  // filled in only if spec.timeCalls
+    double seconds;
+};
+
+  // Fill spec from "tournament <type1> <type2> [--games N] [--threads N]
+  // [--rows R] [--cols C] [--fleet standard|5A,4B,...] [--seed S]
+  // [--log path] [--latency] [--batch K]" or from
+  // "replay <type1> <type2> --seed S --game K [--rows R] [--cols C]
+  // [--fleet ...]".  Prints a message and returns false on bad input.
+bool parseTournamentArgs(int argc, char* argv[], TournamentSpec& spec);
+
+  // Fill fleet from "standard" or a list like "5A,4B,3D"; false if text
+  // is neither.
+bool parseFleet(const std::string& text, std::vector<ShipSpec>& fleet);
+
+bool addFleet(Game& g, const std::vector<ShipSpec>& fleet);
+
+  // Play spec.nGames independent games spread over spec.nThreads threads.
+  // Game k lets type1 move first when k is odd, type2 otherwise.  With
+  // spec.batchSlots, the games are played by BatchAttackers (see
+  // BatchEngine.h), with fleets placed as in unbatched games.  Each worker
+  // plays its games out of its own Arena, reset between games.
+  //
+  // Given goOn, the games are handed out in chunks of chunkGames, in
+  // order, and once every game of a chunk has been played goOn is called
+  // with the wins and noResult so far; the run stops early if it returns
+  // false.  The workers and their players last the whole run, so a player
+  // that learns across games goes on learning from chunk to chunk.
+TournamentResult runTournament(const TournamentSpec& spec, long long chunkGames = 0,
+                               const std::function<bool(const TournamentResult&)>& goOn = nullptr);
+
+  // Play game spec.replayGame again, exactly as the tournament with the same
+  // spec and seed played it, narrating every turn.  If a player learns
+  // across games, that holds for tournaments played with one thread.
+void replayTournamentGame(const TournamentSpec& spec);
+void reportTournament(const TournamentSpec& spec, const TournamentResult& result);
+
+#endif // TOURNAMENT_INCLUDED
@@ -0,0 +1,386 @@
+// Microbenchmarks for the engine's hot paths.  Build the benchmark target
+// from the top of the tree with
+//
+//   cmake -S . -B build && cmake --build build --target benchmark
+//
+// and run "benchmark [--save file] [--baseline file] [--tolerance pct]".
+// --save writes the results; --baseline compares against results saved
+// earlier and exits with status 1 if anything got worse by more than the
+// tolerance (default 10%).
+
+#include "Game.h"
+#include "Board.h"
+#include "Player.h"
+#include "GameObserver.h"
+#include "Arena.h"
+#include "DensityMap.h"
+#include "PlacementKernels.h"
+#include "FixedBoard.h"
+#include "globals.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <functional>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+using namespace std;
+
+//******************** allocation counting ****************************
+
+static atomic<long long> allocationCount(0);
+
+void* operator new(size_t size)
+{
+    allocationCount++;
+    void* p = malloc(size == 0 ? 1 : size);
+    if ( p == nullptr )
+        throw bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+//******************** measurement ************************************
+
+struct Result
+{
+    string name;
+    double value;
+    string unit;
+    bool higherIsBetter;
+};
+
+vector<Result> results;
+
+  // Run body (which does opsPerCall operations) until at least minSeconds
+  // have passed; record the average time per operation in nanoseconds.
+void timeIt(const string& name, int opsPerCall, const function<void()>& body,
+            double minSeconds = 0.3)
+{
+    seedRandom(12345);
+    body();                       // warm up caches and lazily built state
+    long long ops = 0;
+    auto start = chrono::steady_clock::now();
+    double elapsed = 0;
+    while ( elapsed < minSeconds )
+    {
+        body();
+        ops += opsPerCall;
+        elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+    results.push_back(Result { name, elapsed * 1e9 / ops, "ns/op", false });
+}
+
+  // Like timeIt, but runs setup before every call to body and times only
+  // body, for operations that use up the state they run on.
+void timeIt(const string& name, int opsPerCall, const function<void()>& setup,
+            const function<void()>& body, double minSeconds = 0.3)
+{
+    seedRandom(12345);
+    setup();
+    body();                       // warm up caches and lazily built state
+    long long ops = 0;
+    double elapsed = 0;
+    while ( elapsed < minSeconds )
+    {
+        setup();
+        auto start = chrono::steady_clock::now();
+        body();
+        elapsed += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        ops += opsPerCall;
+    }
+    results.push_back(Result { name, elapsed * 1e9 / ops, "ns/op", false });
+}
+
+void addStandardFleet(Game& g)
+{
+    for ( int i = 0; i < STANDARD_FLEET_SIZE; i++)
+        g.addShip(STANDARD_FLEET[i].length, STANDARD_FLEET[i].symbol, STANDARD_FLEET[i].name);
+}
+
+  // Every computer player type, with the sampling ones pinned to fixed
+  // counts so a change of default doesn't move the baseline
+vector<string> benchPlayerTypes()
+{
+    vector<string> types = computerPlayerTypes();
+    for ( int i = 0; i < types.size(); i++)
+    {
+        if ( types[i] == "montecarlo" )
+            types[i] = "montecarlo:500";
+        else if ( types[i] == "adaptive-place" )
+            types[i] = "adaptive-place:512";
+    }
+    return types;
+}
+
+const vector<string> playerTypes = benchPlayerTypes();
+
+//******************** benchmarks *************************************
+
+void benchBoard()
+{
+    Game g(10, 10);
+    addStandardFleet(g);
+    Board b(g);
+
+    timeIt("board.placeShip+unplaceShip", 100, [&] {
+        for ( int i = 0; i < 100; i++)
+        {
+            Point p(i / 10, i % 10);
+            Direction dir = (i % 2 == 0 ? HORIZONTAL : VERTICAL);
+            if ( b.placeShip(p, 0, dir) )
+                b.unplaceShip(p, 0, dir);
+        }
+    });
+
+    Player* placer = createPlayer("good", "placer", g);
+    timeIt("board.attack", 100, [&] {
+        b.clear();
+        placer->placeShips(b);
+    }, [&] {
+        bool shotHit, shipDestroyed;
+        int shipId;
+        for ( int i = 0; i < 100; i++)
+            b.attack(Point(i / 10, i % 10), shotHit, shipDestroyed, shipId);
+    });
+
+    b.clear();
+    placer->placeShips(b);
+    volatile bool sink = false;
+    timeIt("board.allShipsDestroyed", 1000, [&] {
+        for ( int i = 0; i < 1000; i++)
+            sink = b.allShipsDestroyed();
+    });
+    delete placer;
+}
+
+void benchDensityMap()
+{
+      // A mid-game grid: a third of the cells shot, a few hits outstanding
+    pmr::vector<char> grid(100, '.');
+    seedRandom(777);
+    for ( int i = 0; i < 100; i++)
+    {
+        if ( randInt(3) == 0 )
+            grid[i] = (randInt(8) == 0 ? 'X' : 'o');
+    }
+    pmr::vector<int> lengths;
+    for ( int length : { 2, 3, 3, 4, 5 } )
+        lengths.push_back(length);
+    DensityMap density(10, 10);
+    timeIt("densityMap.compute", 100, [&] {
+        for ( int i = 0; i < 100; i++)
+            density.compute(grid, lengths);
+    });
+}
+
+void benchPlaceShips()
+{
+    Game g(10, 10);
+    addStandardFleet(g);
+    Board b(g);
+    NullGameObserver observer;
+    seedRandom(12345);
+    for ( int t = 0; t < playerTypes.size(); t++)
+    {
+        Player* p = createPlayer(playerTypes[t], "placer", g);
+        if ( p->learnsAcrossGames() )
+        {
+              // One game first, so the player places from what it learned
+            Player* opponent = createPlayer("mediocre", "opponent", g);
+            g.play(p, opponent, observer);
+            p->reset();
+            delete opponent;
+        }
+        timeIt(string("placeShips.") + playerTypes[t], 1, [&] {
+            b.clear();
+            p->placeShips(b);
+        });
+        delete p;
+    }
+}
+
+void benchRecommendAttack()
+{
+    for ( int t = 0; t < playerTypes.size(); t++)
+    {
+        long long calls = 0;
+        double seconds = 0;
+        seedRandom(12345);
+        Game g(10, 10);
+        addStandardFleet(g);
+        Board b(g);
+        Player* defender = createPlayer("mediocre", "defender", g);
+        Player* attacker = createPlayer(playerTypes[t], "attacker", g);
+        for ( int game = 0; seconds < 0.3; game++)
+        {
+            b.clear();
+            defender->placeShips(b);
+            for ( int shots = 0; !b.allShipsDestroyed() && shots < 1000; shots++)
+            {
+                auto start = chrono::steady_clock::now();
+                Point p = attacker->recommendAttack();
+                seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                calls++;
+                bool shotHit = false, shipDestroyed = false;
+                int shipId = -1;
+                bool valid = b.attack(p, shotHit, shipDestroyed, shipId);
+                attacker->recordAttackResult(p, valid, shotHit, shipDestroyed, shipId);
+            }
+              // Reset rather than recreate, so a learning attacker carries
+              // what it saw into the next game
+            attacker->reset();
+            defender->reset();
+        }
+        delete attacker;
+        delete defender;
+        results.push_back(Result { string("recommendAttack.") + playerTypes[t],
+                                   seconds * 1e9 / calls, "ns/op", false });
+    }
+}
+
+void benchGames()
+{
+    const char* pairs[][2] = {
+        { "good", "mediocre" }, { "density", "good" }, { "mediocre", "awful" },
+        { "montecarlo:500", "density" }
+    };
+    for ( int i = 0; i < sizeof(pairs) / sizeof(pairs[0]); i++)
+    {
+        string name = string("game.") + pairs[i][0] + "-vs-" + pairs[i][1];
+        long long games = 0;
+        long long allocations = 0;
+        NullGameObserver observer;
+        Arena arena;
+        auto start = chrono::steady_clock::now();
+        double elapsed = 0;
+        while ( elapsed < 0.5 )
+        {
+            seedRandom(12345, games);
+            long long before = allocationCount;
+            {
+                ArenaScope scope(arena);    // as tournament workers play
+                Game g(10, 10);
+                addStandardFleet(g);
+                Player* p1 = createPlayer(pairs[i][0], "p1", g);
+                Player* p2 = createPlayer(pairs[i][1], "p2", g);
+                g.play(p1, p2, observer);
+                delete p1;
+                delete p2;
+            }
+            arena.reset();
+            allocations += allocationCount - before;
+            games++;
+            elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        }
+        results.push_back(Result { name + ".gamesPerSec", games / elapsed, "games/s", true });
+        results.push_back(Result { name + ".allocsPerGame", double(allocations) / games, "allocs", false });
+    }
+}
+
+//******************** baseline files *********************************
+
+bool saveResults(const string& path)
+{
+    ofstream out(path);
+    if ( !out )
+        return false;
+    for ( int i = 0; i < results.size(); i++)
+        out << results[i].name << ' ' << results[i].value << '\n';
+    return bool(out);
+}
+
+  // Returns the number of results more than tolerance percent worse than
+  // the baseline, or -1 if the baseline can't be read.
+int compareResults(const string& path, double tolerance)
+{
+    ifstream in(path);
+    if ( !in )
+        return -1;
+    map<string, double> baseline;
+    string name;
+    double value;
+    while ( in >> name >> value )
+        baseline[name] = value;
+
+    int regressions = 0;
+    cout << endl << "Compared with " << path << ":" << endl;
+    for ( int i = 0; i < results.size(); i++)
+    {
+        const Result& r = results[i];
+        if ( baseline.count(r.name) == 0 || baseline[r.name] == 0 )
+            continue;
+        double change = 100.0 * (r.value - baseline[r.name]) / baseline[r.name];
+        double worse = (r.higherIsBetter ? -change : change);
+        cout << "  " << r.name << ": " << (change >= 0 ? "+" : "") << change << "%";
+        if ( worse > tolerance )
+        {
+            cout << "  REGRESSION";
+            regressions++;
+        }
+        cout << endl;
+    }
+    return regressions;
+}
+
+int main(int argc, char* argv[])
+{
+    string savePath;
+    string baselinePath;
+    double tolerance = 10;
+    for ( int i = 1; i + 1 < argc; i += 2)
+    {
+        string option = argv[i];
+        if ( option == "--save" )
+            savePath = argv[i+1];
+        else if ( option == "--baseline" )
+            baselinePath = argv[i+1];
+        else if ( option == "--tolerance" )
+            tolerance = atof(argv[i+1]);
+        else
+        {
+            cout << "Usage: " << argv[0] << " [--save file] [--baseline file] [--tolerance pct]" << endl;
+            return 2;
+        }
+    }
+
+    benchBoard();
+    benchDensityMap();
+    benchPlaceShips();
+    benchRecommendAttack();
+    benchGames();
+
+    cout << "coverage kernel: " << coverageKernel() << endl;
+    for ( int i = 0; i < results.size(); i++)
+        cout << results[i].name << ": " << results[i].value << " " << results[i].unit << endl;
+
+    if ( !savePath.empty() && !saveResults(savePath) )
+    {
+        cout << "Could not write " << savePath << endl;
+        return 2;
+    }
+    if ( !baselinePath.empty() )
+    {
+        int regressions = compareResults(baselinePath, tolerance);
+        if ( regressions < 0 )
+        {
+            cout << "Could not read " << baselinePath << endl;
+            return 2;
+        }
+        return regressions == 0 ? 0 : 1;
+    }
+    return 0;
+}
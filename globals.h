@@ -2,9 +2,13 @@
 #define GLOBALS_INCLUDED
 
 #include <random>
+#include <cstdint>
+#include <cstddef>
 
-const int MAXROWS = 10;
-const int MAXCOLS = 10;
+  // Largest board a Game accepts.  Boards, players and their bookkeeping
+  // are all sized from Game::rows() and Game::cols() at run time.
+const int MAXROWS = 4096;
+const int MAXCOLS = 4096;
 
 enum Direction {
     HORIZONTAL, VERTICAL
@@ -19,13 +23,81 @@ class Point
     int c;
 };
 
+  // Every thread draws from its own generator, so parallel games never
+  // contend on it.  Reseeding with seedRandom before a game is set up makes
+  // the game (placements, blocks, and every random choice a player makes)
+  // depend only on (seed, gameIndex), so any single game can be replayed.
+inline std::mt19937& randomGenerator()
+{
+    thread_local std::mt19937 generator(std::random_device{}());
+    return generator;
+}
+
+  // std::seed_seq's mixing for a fixed four-word seed.  It fills exactly
+  // what std::seed_seq would, but without the heap allocation std::seed_seq
+  // makes to store its input.
+class SeedSequence
+{
+  public:
+    typedef std::uint_least32_t result_type;
+
+    SeedSequence(unsigned long long seed, unsigned long long gameIndex)
+     : m_v { result_type(seed & 0xFFFFFFFF), result_type(seed >> 32),
+             result_type(gameIndex & 0xFFFFFFFF), result_type(gameIndex >> 32) }
+    {}
+
+    template<typename It>
+    void generate(It begin, It end) const
+    {
+        const size_t s = 4;
+        size_t n = end - begin;
+        if ( n == 0 )
+            return;
+        for ( It it = begin; it != end; ++it)
+            *it = 0x8b8b8b8b;
+        size_t t = (n >= 623 ? 11 : n >= 68 ? 7 : n >= 39 ? 5 : n >= 7 ? 3 : (n - 1) / 2);
+        size_t p = (n - t) / 2;
+        size_t q = p + t;
+        size_t m = (s + 1 > n ? s + 1 : n);
+        for ( size_t k = 0; k < m; k++)
+        {
+            result_type r1 = 1664525u * mix(begin[k % n] ^ begin[(k + p) % n] ^ begin[(k + n - 1) % n]);
+            result_type r2 = r1 + result_type(k == 0 ? s : k <= s ? k % n + m_v[k-1] : k % n);
+            begin[(k + p) % n] = result_type(begin[(k + p) % n] + r1);
+            begin[(k + q) % n] = result_type(begin[(k + q) % n] + r2);
+            begin[k % n] = r2;
+        }
+        for ( size_t k = m; k < m + n; k++)
+        {
+            result_type r3 = 1566083941u * mix(result_type(begin[k % n] + begin[(k + p) % n] + begin[(k + n - 1) % n]));
+            result_type r4 = result_type(r3 - k % n);
+            begin[(k + p) % n] = result_type(begin[(k + p) % n] ^ r3);
+            begin[(k + q) % n] = result_type(begin[(k + q) % n] ^ r4);
+            begin[k % n] = r4;
+        }
+    }
+
+  private:
+    result_type m_v[4];
+
+    static result_type mix(result_type x) { return result_type((x ^ (x >> 27)) & 0xFFFFFFFF); }
+};
+
+inline void seedRandom(unsigned long long seed, unsigned long long gameIndex = 0)
+{
+    SeedSequence seq(seed, gameIndex);
+    randomGenerator().seed(seq);
+}
+
   // Return a uniformly distributed random int from 0 to limit-1
 inline int randInt(int limit)
 {
-    static std::random_device rd;
-    static std::mt19937 generator(rd());
     std::uniform_int_distribution<> distro(0, limit-1);
-    return distro(generator);
+    return distro(randomGenerator());
 }
 
+  // Random tries at dropping a ship on free cells before a randomly drawn
+  // fleet (PlacementSampler, LayoutSearch) is given up on
+const int DROP_TRIES = 64;
+
 #endif // GLOBALS_INCLUDED
@@ -1,26 +1,64 @@
 #include "Game.h"
 #include "Player.h"
+#include "Tournament.h"
+#include "GameLog.h"
+#include "Match.h"
+#include "Ladder.h"
+#include "GameObserver.h"
+#include "FixedBoard.h"
 #include <iostream>
 #include <string>
+#include <vector>
 #include <cassert>
 using namespace std;
 
 bool addStandardShips(Game& g)
 {
-    return g.addShip(5, 'A', "aircraft carrier")  &&
-           g.addShip(4, 'B', "battleship")  &&
-           g.addShip(3, 'D', "destroyer")  &&
-           g.addShip(3, 'S', "submarine")  &&
-           g.addShip(2, 'P', "patrol boat");
+    for (int i = 0; i < STANDARD_FLEET_SIZE; i++)
+    {
+        if (!g.addShip(STANDARD_FLEET[i].length, STANDARD_FLEET[i].symbol, STANDARD_FLEET[i].name))
+            return false;
+    }
+    return true;
 }
 
 #include "globals.h"
 
 #include <list>
-int main()
+int main(int argc, char* argv[])
 {
     const int NTRIALS = 500;
 
+    if (argc > 1)
+    {
+        TournamentSpec spec;
+        string command = argv[1];
+        if (command == "logstats")
+            return reportGameLogs(vector<string>(argv + 2, argv + argc)) ? 0 : 1;
+        if (command == "ladder")
+        {
+            LadderSpec ladder;
+            if (!parseLadderArgs(argc, argv, ladder))
+                return 1;
+            reportLadder(ladder, runLadder(ladder));
+            return 0;
+        }
+        if (command != "tournament"  &&  command != "replay")
+        {
+            cout << "Usage: " << argv[0] << " [tournament|replay <type1> <type2> [options]]" << endl;
+            cout << "       " << argv[0] << " ladder [--types t1,t2,...] [options]" << endl;
+            cout << "       " << argv[0] << " logstats <log> ..." << endl;
+            return 1;
+        }
+        if (!parseTournamentArgs(argc, argv, spec))
+            return 1;
+        if (command == "replay")
+            replayTournamentGame(spec);
+        else
+            reportTournament(spec, runTournament(spec));
+        return 0;
+    }
+
     cout << "Select one of these choices for an example of the game:" << endl;
     cout << "  1.  A mini-game between two mediocre players" << endl;
     cout << "  2.  A mediocre player against a human player" << endl;
@@ -59,21 +97,22 @@ int main()
     {
         int nMediocreWins = 0;
 
+        Game g(10, 10);
+        addStandardShips(g);
+        Player* p1 = createPlayer("mediocre", "Mediocre Mimi", g);
+        Player* p2 = createPlayer("good", "Good Goober", g);
+        Match match(g, p1, p2);
+        ConsoleGameObserver console;
         for (int k = 1; k <= NTRIALS; k++)
         {
             cout << "============================= Game " << k
                  << " =============================" << endl;
-            Game g(10, 10);
-            addStandardShips(g);
-            Player* p1 = createPlayer("mediocre", "Mediocre Mimi", g);
-            Player* p2 = createPlayer("good", "Good Goober", g);
-            Player* winner = (k % 2 == 1 ?
-                                g.play(p1, p2, false) : g.play(p2, p1, false));
+            Player* winner = match.play(k % 2 == 1, console);
             if (winner == p1)
                 nMediocreWins++;
-            delete p1;
-            delete p2;
         }
+        delete p1;
+        delete p2;
         cout << "The mediocre player won " << nMediocreWins << " out of "
              << NTRIALS << " games." << endl;
           // We'd expect a mediocre player to win most of the games against